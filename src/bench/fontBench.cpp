@@ -0,0 +1,198 @@
+#include "platform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <stb_image.h>
+
+#include "colorKey.h"
+#include "fontBase.h"
+#include "fontCache.h"
+#include "fontHDZero.h"
+#include "fontWalksnail.h"
+#include "fontWtfOs.h"
+#include "perfCounters.h"
+
+// Opt-in benchmark, configure with -DBUILD_FONT_BENCH=ON and run
+//   font_bench [fonts dir]
+// Times are the best of BENCH_RUNS runs. Exits with 1 if the colour key
+// variants don't produce identical output.
+
+#define BENCH_RUNS 10
+
+// Set by CMake to the bundled fonts
+#ifndef FONT_BENCH_FONTS_DIR
+    #define FONT_BENCH_FONTS_DIR "fonts"
+#endif
+
+using namespace std::chrono;
+
+static int mismatches = 0;
+
+typedef std::function<std::shared_ptr<FontBase>()> fontFactory_t;
+
+typedef struct {
+    std::string name;
+    fontFactory_t create;
+} benchFont_t;
+
+static std::vector<benchFont_t> findFonts(std::filesystem::path fontsDir)
+{
+    std::vector<benchFont_t> fonts;
+    std::vector<std::pair<std::string, bool>> subDirs = {{"wtfos", true}, {"hdzero", false}, {"walksnail", false}};
+    for (const std::pair<std::string, bool> &subDir : subDirs) {
+        std::filesystem::path dir = fontsDir / subDir.first;
+        if (!std::filesystem::exists(dir)) {
+            continue;
+        }
+
+        std::vector<std::filesystem::path> paths;
+        for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(dir)) {
+            if (entry.is_directory() == subDir.second) {
+                paths.push_back(entry.path());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+
+        for (const std::filesystem::path &path : paths) {
+            fontFactory_t create;
+            if (subDir.first == "wtfos") {
+                create = [path]() { return std::make_shared<FontWtfOS>(path); };
+            } else if (subDir.first == "hdzero") {
+                create = [path]() { return std::make_shared<FontHDZero>(path); };
+            } else {
+                create = [path]() { return std::make_shared<FontWalksnail>(path); };
+            }
+            fonts.push_back({subDir.first + "/" + path.filename().string(), create});
+        }
+    }
+    return fonts;
+}
+
+// Best time of a fresh font object loading, -1 if the font does not load
+static int64_t timeLoad(const fontFactory_t &create)
+{
+    int64_t best = -1;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        std::shared_ptr<FontBase> font = create();
+        steady_clock::time_point start = steady_clock::now();
+        if (!font->load()) {
+            return -1;
+        }
+        int64_t time = duration_cast<microseconds>(steady_clock::now() - start).count();
+        best = best < 0 ? time : std::min(best, time);
+    }
+    return best;
+}
+
+static void benchFontCache(std::filesystem::path fontsDir, std::filesystem::path cacheDir)
+{
+    printf("Font load, best of %d runs\n", BENCH_RUNS);
+    printf("%-60s %12s %12s\n", "font", "cold us", "warm us");
+
+    for (const benchFont_t &font : findFonts(fontsDir)) {
+        // Cold: decoded from the font files, the cache is disabled
+        FontCache::setCacheDir(std::filesystem::path());
+        int64_t cold = timeLoad(font.create);
+
+        // Warm: the first load writes the cache file, every timed one maps it
+        FontCache::setCacheDir(cacheDir);
+        font.create()->load();
+        int64_t warm = timeLoad(font.create);
+
+        if (cold < 0 || warm < 0) {
+            printf("%-60s %12s %12s\n", font.name.c_str(), "failed", "failed");
+        } else {
+            printf("%-60s %12lld %12lld\n", font.name.c_str(), static_cast<long long>(cold), static_cast<long long>(warm));
+        }
+    }
+    printf("WtfOS glyphs are mapped straight from their .bin files and never cached, cold and warm match\n");
+
+    // The plugin's datarefs report the same counters, totals over every load above
+    printf("\n%-60s %12s\n", "counter", "total");
+    for (perfCounter_e counter : {PERF_FONT_CACHE_LOADS, PERF_FONT_DECODES, PERF_FONT_LOAD_US}) {
+        printf("%-60s %12lld\n", PerfCounters::getName(counter), static_cast<long long>(PerfCounters::instance()->get(counter)));
+    }
+}
+
+static void benchColorKey(std::filesystem::path fontsDir)
+{
+    std::filesystem::path dir = fontsDir / "hdzero";
+    if (!std::filesystem::exists(dir)) {
+        return;
+    }
+
+    std::vector<std::filesystem::path> sheets;
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.is_regular_file()) {
+            sheets.push_back(entry.path());
+        }
+    }
+    std::sort(sheets.begin(), sheets.end());
+
+    printf("\nColour key over a whole HDZero sheet, best of %d runs, selected variant %s\n", BENCH_RUNS, ColorKey::getVariantName());
+    printf("%-60s %8s %12s %8s\n", "sheet", "variant", "us", "output");
+
+    for (const std::filesystem::path &sheet : sheets) {
+        int width, height, channels;
+        uint8_t *image = stbi_load(sheet.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        if (!image) {
+            printf("%-60s unable to load\n", sheet.filename().string().c_str());
+            continue;
+        }
+
+        const size_t pixels = static_cast<size_t>(width) * height;
+        std::vector<uint8_t> reference(pixels * BYTES_PER_PIXEL_RGBA);
+        std::vector<uint8_t> output(pixels * BYTES_PER_PIXEL_RGBA);
+        ColorKey::keyToAlphaVariant(COLOR_KEY_SCALAR, image, reference.data(), pixels);
+
+        for (int i = 0; i < COLOR_KEY_VARIANT_COUNT; i++) {
+            colorKeyVariant_e variant = static_cast<colorKeyVariant_e>(i);
+            int64_t best = -1;
+            bool supported = true;
+            for (int run = 0; run < BENCH_RUNS && supported; run++) {
+                std::fill(output.begin(), output.end(), 0);
+                steady_clock::time_point start = steady_clock::now();
+                supported = ColorKey::keyToAlphaVariant(variant, image, output.data(), pixels);
+                int64_t time = duration_cast<microseconds>(steady_clock::now() - start).count();
+                best = best < 0 ? time : std::min(best, time);
+            }
+
+            if (!supported) {
+                printf("%-60s %8s %12s %8s\n", sheet.filename().string().c_str(), ColorKey::getVariantName(variant), "-", "n/a");
+                continue;
+            }
+            // Every variant has to produce the scalar output byte for byte
+            const bool match = memcmp(output.data(), reference.data(), output.size()) == 0;
+            printf("%-60s %8s %12lld %8s\n", sheet.filename().string().c_str(), ColorKey::getVariantName(variant), static_cast<long long>(best), match ? "match" : "MISMATCH");
+            if (!match) {
+                mismatches++;
+            }
+        }
+        stbi_image_free(image);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::filesystem::path fontsDir = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::path(FONT_BENCH_FONTS_DIR);
+    if (!std::filesystem::exists(fontsDir)) {
+        fprintf(stderr, "Fonts directory not found: %s\n", fontsDir.string().c_str());
+        return 1;
+    }
+
+    std::filesystem::path cacheDir = std::filesystem::temp_directory_path() / "font_bench_cache";
+    std::filesystem::remove_all(cacheDir);
+    std::filesystem::create_directories(cacheDir);
+
+    benchFontCache(fontsDir, cacheDir);
+    benchColorKey(fontsDir);
+
+    std::filesystem::remove_all(cacheDir);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+#include "platform.h"
+
+#include <cstdio>
+#include <XPLMUtilities.h>
+
+// The benchmark runs outside X-Plane, the log goes to stderr instead of Log.txt
+void XPLMDebugString(const char *inString)
+{
+    fputs(inString, stderr);
+}
@@ -0,0 +1,123 @@
+#include "colorKey.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define COLOR_KEY_X86
+    #include <immintrin.h>
+#endif
+
+#define RGB_MASK    0x00ffffff
+#define ALPHA_MASK  0xff000000
+
+namespace ColorKey {
+
+    typedef void (*keyFunction_t)(const uint8_t *src, uint8_t *dst, size_t pixels);
+
+    static void keyToAlphaScalar(const uint8_t *src, uint8_t *dst, size_t pixels)
+    {
+        for (size_t i = 0; i < pixels; i++) {
+            uint32_t pixel;
+            memcpy(&pixel, src + i * 4, sizeof(pixel));
+            pixel = (pixel & RGB_MASK) == COLOR_KEY_RGB ? 0 : (pixel | ALPHA_MASK);
+            memcpy(dst + i * 4, &pixel, sizeof(pixel));
+        }
+    }
+
+#ifdef COLOR_KEY_X86
+    __attribute__((target("sse2")))
+    static void keyToAlphaSse2(const uint8_t *src, uint8_t *dst, size_t pixels)
+    {
+        const __m128i rgbMask = _mm_set1_epi32(RGB_MASK);
+        const __m128i key = _mm_set1_epi32(COLOR_KEY_RGB);
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(ALPHA_MASK));
+
+        size_t i = 0;
+        for (; i + 4 <= pixels; i += 4) {
+            __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            __m128i isKey = _mm_cmpeq_epi32(_mm_and_si128(value, rgbMask), key);
+            value = _mm_andnot_si128(isKey, _mm_or_si128(value, alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), value);
+        }
+        keyToAlphaScalar(src + i * 4, dst + i * 4, pixels - i);
+    }
+
+    __attribute__((target("avx2")))
+    static void keyToAlphaAvx2(const uint8_t *src, uint8_t *dst, size_t pixels)
+    {
+        const __m256i rgbMask = _mm256_set1_epi32(RGB_MASK);
+        const __m256i key = _mm256_set1_epi32(COLOR_KEY_RGB);
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(ALPHA_MASK));
+
+        size_t i = 0;
+        for (; i + 8 <= pixels; i += 8) {
+            __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+            __m256i isKey = _mm256_cmpeq_epi32(_mm256_and_si256(value, rgbMask), key);
+            value = _mm256_andnot_si256(isKey, _mm256_or_si256(value, alpha));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), value);
+        }
+        keyToAlphaSse2(src + i * 4, dst + i * 4, pixels - i);
+    }
+#endif
+
+    static keyFunction_t selectVariant(const char **name)
+    {
+#ifdef COLOR_KEY_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            *name = "AVX2";
+            return &keyToAlphaAvx2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            *name = "SSE2";
+            return &keyToAlphaSse2;
+        }
+#endif
+        *name = "scalar";
+        return &keyToAlphaScalar;
+    }
+
+    static const char *variantName = nullptr;
+    static const keyFunction_t keyFunction = selectVariant(&variantName);
+
+    void keyToAlpha(const uint8_t *src, uint8_t *dst, size_t pixels)
+    {
+        keyFunction(src, dst, pixels);
+    }
+
+    const char *getVariantName()
+    {
+        return variantName;
+    }
+
+    bool keyToAlphaVariant(colorKeyVariant_e variant, const uint8_t *src, uint8_t *dst, size_t pixels)
+    {
+        switch (variant) {
+            case COLOR_KEY_SCALAR:
+                keyToAlphaScalar(src, dst, pixels);
+                return true;
+#ifdef COLOR_KEY_X86
+            case COLOR_KEY_SSE2:
+                if (!__builtin_cpu_supports("sse2")) {
+                    return false;
+                }
+                keyToAlphaSse2(src, dst, pixels);
+                return true;
+            case COLOR_KEY_AVX2:
+                if (!__builtin_cpu_supports("avx2")) {
+                    return false;
+                }
+                keyToAlphaAvx2(src, dst, pixels);
+                return true;
+#endif
+            default:
+                return false;
+        }
+    }
+
+    const char *getVariantName(colorKeyVariant_e variant)
+    {
+        static const char *names[COLOR_KEY_VARIANT_COUNT] = {"scalar", "SSE2", "AVX2"};
+        return variant < COLOR_KEY_VARIANT_COUNT ? names[variant] : "";
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// HDZero fonts mark transparent pixels with a grey key colour
+#define COLOR_KEY_RGB 0x007f7f7f
+
+typedef enum {
+    COLOR_KEY_SCALAR = 0,
+    COLOR_KEY_SSE2,
+    COLOR_KEY_AVX2,
+    COLOR_KEY_VARIANT_COUNT
+} colorKeyVariant_e;
+
+namespace ColorKey {
+    // Converts a row of RGBA pixels: key coloured pixels become fully transparent 
+    // black, all other pixels fully opaque. Uses the widest SIMD variant the CPU 
+    // supports, selected when the plugin is loaded.
+    void keyToAlpha(const uint8_t *src, uint8_t *dst, size_t pixels);
+
+    const char *getVariantName();
+
+    // Runs the given variant instead of the selected one, for benchmarks.
+    // Returns false if the CPU or the build lacks it.
+    bool keyToAlphaVariant(colorKeyVariant_e variant, const uint8_t *src, uint8_t *dst, size_t pixels);
+    const char *getVariantName(colorKeyVariant_e variant);
+}
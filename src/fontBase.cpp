@@ -1,5 +1,37 @@
 #include "fontBase.h"
 
+#include <cstring>
+
+#include "helper.h"
+#include "perfCounters.h"
+#include "workerPool.h"
+#include "fontCache.h"
+#include "glyphConvert.h"
+
+using namespace Helper;
+
+std::atomic<textureCompression_e> FontBase::textureCompression = TEXTURE_COMPRESSION_NONE;
+
+void GlyphSlabDeleter::operator()(uint8_t *slab) const
+{
+    ::operator delete[](slab, std::align_val_t(GLYPH_SLAB_ALIGNMENT));
+}
+
+void FontBase::setTextureCompression(textureCompression_e compression)
+{
+    textureCompression = compression;
+}
+
+textureCompression_e FontBase::getTextureCompression()
+{
+    return textureCompression;
+}
+
+FontBase::FontBase(std::filesystem::path path)
+{
+    this->path = path;
+}
+
 std::string FontBase::getName()
 {
     return this->name;
@@ -15,7 +47,203 @@ unsigned int FontBase::getCharHeight()
     return this->charHeight;
 }
 
-std::vector<std::vector<uint8_t>> FontBase::getTextures()
+GlyphView FontBase::getGlyphs()
+{
+    return GlyphView(this->glyphBlocks, this->charWidth, this->charHeight, this->glyphCount, this->glyphByteSize, this->glyphFormat);
+}
+
+uint8_t *FontBase::allocateSlab(unsigned int count, unsigned int byteSize)
+{
+    size_t size = static_cast<size_t>(count) * byteSize;
+    uint8_t *data = static_cast<uint8_t*>(::operator new[](size, std::align_val_t(GLYPH_SLAB_ALIGNMENT)));
+    memset(data, 0, size);
+
+    this->slab.reset(data);
+    this->glyphBlocks.push_back({data, 0, count});
+    this->glyphCount = count;
+    this->glyphByteSize = byteSize;
+    this->glyphFormat = GLYPH_FORMAT_RGBA8;
+    return data;
+}
+
+bool FontBase::isCacheable()
+{
+    return true;
+}
+
+std::vector<std::filesystem::path> FontBase::getSourceFiles()
+{
+    return {this->path};
+}
+
+bool FontBase::isValid()
+{
+    return this->valid;
+}
+
+bool FontBase::isLoaded()
+{
+    return this->loaded;
+}
+
+bool FontBase::prefetch(std::function<void()> onLoaded)
+{
+    if (this->loaded || !this->valid || this->pending.valid()) {
+        return false;
+    }
+
+    std::shared_ptr<FontBase> self = shared_from_this();
+    this->pending = WorkerPool::instance()->submit([self, onLoaded]() {
+        bool loaded = self->loadTimed();
+        if (onLoaded) {
+            onLoaded();
+        }
+        return loaded;
+    });
+    return true;
+}
+
+bool FontBase::load()
+{
+    if (this->loaded) {
+        return true;
+    }
+
+    if (!this->valid) {
+        return false;
+    }
+
+    if (this->pending.valid()) {
+        this->loaded = this->pending.get();
+        this->pending = std::shared_future<bool>();
+    } else {
+        this->loaded = this->loadTimed();
+    }
+
+    if (!this->loaded) {
+        this->releaseGlyphs();
+        this->valid = false;
+    }
+    return this->loaded;
+}
+
+void FontBase::unload()
+{
+    if (this->pending.valid()) {
+        this->pending.wait();
+        this->pending = std::shared_future<bool>();
+    } else if (!this->loaded) {
+        return;
+    }
+
+    LogDebug("Evicting font: ", this->name);
+    this->releaseGlyphs();
+    this->loaded = false;
+}
+
+void FontBase::releaseGlyphs()
+{
+    this->glyphBlocks.clear();
+    this->slab.reset();
+    this->mappedFiles.clear();
+    this->glyphCount = 0;
+    this->glyphByteSize = 0;
+    this->glyphFormat = GLYPH_FORMAT_RGBA8;
+}
+
+bool FontBase::loadTimed()
 {
-    return this->textures;
+    // Converted glyphs are worth caching even for fonts that are cheap to load as RGBA
+    textureCompression_e compression = textureCompression;
+    bool useCache = this->isCacheable() || compression != TEXTURE_COMPRESSION_NONE;
+
+    steady_clock::time_point start = steady_clock::now();
+    if (useCache && this->loadCache(compression)) {
+        int64_t time = duration_cast<microseconds>(steady_clock::now() - start).count();
+        PerfCounters::instance()->add(PERF_FONT_CACHE_LOADS);
+        PerfCounters::instance()->add(PERF_FONT_LOAD_US, time);
+        Log("Font ", this->name, " loaded from cache in ", time, " us");
+        return true;
+    }
+
+    if (!this->decode()) {
+        return false;
+    }
+
+    if (this->glyphCount == 0) {
+        return false;
+    }
+    if (compression != TEXTURE_COMPRESSION_NONE) {
+        this->convert(compression);
+    }
+    int64_t time = duration_cast<microseconds>(steady_clock::now() - start).count();
+    PerfCounters::instance()->add(PERF_FONT_DECODES);
+    PerfCounters::instance()->add(PERF_FONT_LOAD_US, time);
+    Log("Font ", this->name, " decoded in ", time, " us");
+
+    if (useCache) {
+        FontCache::store(this->path, this->getSourceFiles(), compression, this->getGlyphs());
+    }
+    return true;
+}
+
+bool FontBase::loadCache(textureCompression_e compression)
+{
+    fontCacheHeader_t header;
+    std::unique_ptr<MappedFile> file = FontCache::load(this->path, this->getSourceFiles(), compression, header);
+    if (!file) {
+        return false;
+    }
+
+    if (header.charWidth != this->charWidth || header.charHeight != this->charHeight || header.format > GLYPH_FORMAT_SDF ||
+        header.glyphByteSize != GlyphView::getLayerSize(static_cast<glyphFormat_e>(header.format), this->charWidth, this->charHeight)) {
+        LogWarning("Font cache does not match font: ", this->name);
+        return false;
+    }
+
+    this->glyphBlocks.push_back({file->getData() + FONT_CACHE_HEADER_SIZE, 0, header.glyphCount});
+    this->mappedFiles.push_back(std::move(file));
+    this->glyphCount = header.glyphCount;
+    this->glyphByteSize = header.glyphByteSize;
+    this->glyphFormat = static_cast<glyphFormat_e>(header.format);
+    return true;
+}
+
+void FontBase::convert(textureCompression_e compression)
+{
+    GlyphView glyphs = this->getGlyphs();
+    glyphFormat_e format = GlyphConvert::selectFormat(glyphs, compression);
+    if (format == GLYPH_FORMAT_RGBA8) {
+        LogDebug("Font ", this->name, " has coloured glyphs, keeping RGBA texture format");
+        return;
+    }
+
+    unsigned int count = this->glyphCount;
+    size_t layerSize = GlyphView::getLayerSize(format, this->charWidth, this->charHeight);
+    std::unique_ptr<uint8_t[], GlyphSlabDeleter> converted(static_cast<uint8_t*>(::operator new[](count * layerSize, std::align_val_t(GLYPH_SLAB_ALIGNMENT))));
+
+    if (format == GLYPH_FORMAT_BC3) {
+        GlyphConvert::compressBc3(glyphs, converted.get());
+    } else if (format == GLYPH_FORMAT_SDF) {
+        GlyphConvert::toDistanceField(glyphs, converted.get());
+    } else {
+        size_t luminanceAlphaSize = GlyphView::getLayerSize(GLYPH_FORMAT_LA8, this->charWidth, this->charHeight);
+        std::unique_ptr<uint8_t[], GlyphSlabDeleter> luminanceAlpha(static_cast<uint8_t*>(::operator new[](count * luminanceAlphaSize, std::align_val_t(GLYPH_SLAB_ALIGNMENT))));
+        GlyphConvert::toLuminanceAlpha(glyphs, luminanceAlpha.get());
+
+        if (format == GLYPH_FORMAT_RGTC2) {
+            std::vector<glyphBlock_t> blocks = {{luminanceAlpha.get(), 0, count}};
+            GlyphConvert::compressRgtc2(GlyphView(blocks, this->charWidth, this->charHeight, count, luminanceAlphaSize, GLYPH_FORMAT_LA8), converted.get());
+        } else {
+            converted = std::move(luminanceAlpha);
+        }
+    }
+
+    // The source may be a mapped file or the decode slab, both are no longer needed
+    this->releaseGlyphs();
+    this->glyphBlocks.push_back({converted.get(), 0, count});
+    this->slab = std::move(converted);
+    this->glyphCount = count;
+    this->glyphByteSize = layerSize;
+    this->glyphFormat = format;
 }
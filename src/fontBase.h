@@ -6,25 +6,71 @@
 #include <string>
 #include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <atomic>
 
-#define BYTES_PER_PIXEL_RGBA 4
+#include "glyphView.h"
+#include "glyphConvert.h"
+#include "mappedFile.h"
 
-class FontBase {
+struct GlyphSlabDeleter {
+    void operator()(uint8_t *slab) const;
+};
+
+class FontBase : public std::enable_shared_from_this<FontBase> {
     
     protected:
-        std::vector<std::vector<uint8_t>> textures;
+        std::filesystem::path path;
         std::string name;
         unsigned int charWidth = 0;
         unsigned int charHeight = 0;
+        bool valid = false;
+        bool loaded = false;
+        std::shared_future<bool> pending;
+        // Decoded glyphs live in one aligned slab, mapped ones in the mapped files
+        std::unique_ptr<uint8_t[], GlyphSlabDeleter> slab;
+        std::vector<std::unique_ptr<MappedFile>> mappedFiles;
+        std::vector<glyphBlock_t> glyphBlocks;
+        unsigned int glyphCount = 0;
+        unsigned int glyphByteSize = 0;
+        glyphFormat_e glyphFormat = GLYPH_FORMAT_RGBA8;
+
+        // Cheap metadata scan (names and glyph size), no pixel data is decoded
+        virtual bool readMetadata() = 0;
+        virtual bool decode() = 0;
+        virtual std::vector<std::filesystem::path> getSourceFiles();
+        virtual bool isCacheable();
+        uint8_t *allocateSlab(unsigned int count, unsigned int byteSize);
 
     private:
-        
+        static std::atomic<textureCompression_e> textureCompression;
+
+        bool loadTimed();
+        bool loadCache(textureCompression_e compression);
+        void convert(textureCompression_e compression);
+        void releaseGlyphs();
     
     public:
+        FontBase(std::filesystem::path path);
+        virtual ~FontBase() = default;
+
+        // Applies to fonts loaded afterwards, converted glyphs are cached per compression mode
+        static void setTextureCompression(textureCompression_e compression);
+        static textureCompression_e getTextureCompression();
+
         std::string getName();
         unsigned int getCharWidth();
         unsigned int getCharHeight();
-        std::vector<std::vector<uint8_t>> getTextures();
+        GlyphView getGlyphs();
+        bool isValid();
+        bool isLoaded();
+        // Starts decoding on the worker pool, onLoaded then runs on the worker.
+        // False if the font is already loaded, being loaded or invalid, onLoaded is not called then.
+        bool prefetch(std::function<void()> onLoaded = nullptr);
+        bool load();
+        void unload();
         virtual int getCols() = 0;
         virtual int getRows() = 0;
-    };
\ No newline at end of file
+    };
@@ -0,0 +1,152 @@
+#include "fontCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "helper.h"
+
+#define FONT_CACHE_MAGIC "IOFC"
+#define FONT_CACHE_EXTENSION ".fcache"
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+using namespace Helper;
+
+std::filesystem::path FontCache::cacheDir;
+
+void FontCache::setCacheDir(std::filesystem::path dir)
+{
+    cacheDir = dir;
+}
+
+uint64_t FontCache::hashPath(std::filesystem::path path)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (char c : path.generic_string()) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+bool FontCache::makeHeader(std::filesystem::path fontPath, std::vector<std::filesystem::path> sourceFiles, textureCompression_e compression, fontCacheHeader_t &header)
+{
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FONT_CACHE_MAGIC, sizeof(header.magic));
+    header.version = FONT_CACHE_VERSION;
+    header.sourceHash = hashPath(fontPath);
+    header.compression = compression;
+
+    for (std::filesystem::path file : sourceFiles) {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(file, error);
+        if (error) {
+            return false;
+        }
+        std::filesystem::file_time_type time = std::filesystem::last_write_time(file, error);
+        if (error) {
+            return false;
+        }
+        header.sourceSize += size;
+        header.sourceTime = std::max<int64_t>(header.sourceTime, time.time_since_epoch().count());
+    }
+    return true;
+}
+
+std::filesystem::path FontCache::getCacheFile(std::filesystem::path fontPath)
+{
+    std::stringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hashPath(fontPath) << FONT_CACHE_EXTENSION;
+    return cacheDir / name.str();
+}
+
+std::unique_ptr<MappedFile> FontCache::load(std::filesystem::path fontPath, std::vector<std::filesystem::path> sourceFiles, textureCompression_e compression, fontCacheHeader_t &header)
+{
+    fontCacheHeader_t expected;
+    if (cacheDir.empty() || !makeHeader(fontPath, sourceFiles, compression, expected)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> file = std::make_unique<MappedFile>();
+    if (!file->open(getCacheFile(fontPath))) {
+        return nullptr;
+    }
+
+    if (file->getSize() < sizeof(fontCacheHeader_t)) {
+        return nullptr;
+    }
+
+    memcpy(&header, file->getData(), sizeof(fontCacheHeader_t));
+    if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+        header.version != expected.version ||
+        header.compression != expected.compression ||
+        header.sourceHash != expected.sourceHash ||
+        header.sourceSize != expected.sourceSize ||
+        header.sourceTime != expected.sourceTime) {
+        LogDebug("Stale font cache: ", fontPath);
+        return nullptr;
+    }
+
+    if (file->getSize() != sizeof(fontCacheHeader_t) + static_cast<size_t>(header.glyphCount) * header.glyphByteSize) {
+        LogWarning("Corrupt font cache: ", getCacheFile(fontPath));
+        return nullptr;
+    }
+
+    return file;
+}
+
+bool FontCache::store(std::filesystem::path fontPath, std::vector<std::filesystem::path> sourceFiles, textureCompression_e compression, const GlyphView &glyphs)
+{
+    fontCacheHeader_t header;
+    if (cacheDir.empty() || glyphs.isEmpty() || !makeHeader(fontPath, sourceFiles, compression, header)) {
+        return false;
+    }
+
+    header.charWidth = glyphs.getWidth();
+    header.charHeight = glyphs.getHeight();
+    header.glyphCount = glyphs.getCount();
+    header.glyphByteSize = glyphs.getStride();
+    header.format = glyphs.getFormat();
+
+    std::error_code error;
+    std::filesystem::create_directories(cacheDir, error);
+    if (error) {
+        LogWarning("Unable to create font cache directory: ", cacheDir);
+        return false;
+    }
+
+    // Write to a temporary file first so a crash never leaves a truncated cache behind
+    std::filesystem::path cacheFile = getCacheFile(fontPath);
+    std::filesystem::path tempFile = cacheFile;
+    tempFile += ".tmp";
+
+    std::ofstream file(tempFile, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if (!file.is_open()) {
+        LogWarning("Unable to write font cache: ", tempFile);
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const glyphBlock_t &block : glyphs) {
+        file.write(reinterpret_cast<const char*>(block.data), static_cast<size_t>(block.count) * header.glyphByteSize);
+    }
+    file.close();
+
+    if (file.fail()) {
+        LogWarning("Unable to write font cache: ", tempFile);
+        std::filesystem::remove(tempFile, error);
+        return false;
+    }
+
+    std::filesystem::rename(tempFile, cacheFile, error);
+    if (error) {
+        LogWarning("Unable to write font cache: ", cacheFile);
+        std::filesystem::remove(tempFile, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "platform.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "glyphView.h"
+#include "glyphConvert.h"
+#include "mappedFile.h"
+
+// Bump whenever the decoded glyph layout changes
+#define FONT_CACHE_VERSION 3
+#define FONT_CACHE_HEADER_SIZE 64
+
+// Cache file layout: header, followed by glyphCount * glyphByteSize bytes of 
+// layer data in the stored glyph format, ready to be uploaded to the texture array.
+// The requested compression is part of the key, format is what the font was converted to.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t charWidth;
+    uint32_t charHeight;
+    uint32_t glyphCount;
+    uint32_t glyphByteSize;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t sourceHash;
+    uint32_t format;
+    uint32_t compression;
+    uint8_t reserved[8];
+} fontCacheHeader_t;
+
+static_assert(sizeof(fontCacheHeader_t) == FONT_CACHE_HEADER_SIZE, "Unexpected font cache header size");
+
+class FontCache {
+    private:
+        static std::filesystem::path cacheDir;
+
+        static uint64_t hashPath(std::filesystem::path path);
+        static bool makeHeader(std::filesystem::path fontPath, std::vector<std::filesystem::path> sourceFiles, textureCompression_e compression, fontCacheHeader_t &header);
+
+    public:
+        // Must be called from the main thread before fonts are loaded, an empty path disables the cache
+        static void setCacheDir(std::filesystem::path dir);
+        static std::filesystem::path getCacheFile(std::filesystem::path fontPath);
+        static std::unique_ptr<MappedFile> load(std::filesystem::path fontPath, std::vector<std::filesystem::path> sourceFiles, textureCompression_e compression, fontCacheHeader_t &header);
+        static bool store(std::filesystem::path fontPath, std::vector<std::filesystem::path> sourceFiles, textureCompression_e compression, const GlyphView &glyphs);
+};
@@ -1,6 +1,7 @@
 #include "fontHDZero.h"
 
 #include "helper.h"
+#include "colorKey.h"
 #include <stb_image.h>
 
 #define OSD_CHAR_WIDTH_24 24
@@ -15,67 +16,78 @@
 
 using namespace Helper;
 
-FontHDZero::FontHDZero(std::filesystem::path path)
+FontHDZero::FontHDZero(std::filesystem::path path) : FontBase(path)
 {
     this->name = path.filename().replace_extension();
-    unsigned int charByteSize = 0, charByteWidth = 0;
+    this->valid = this->readMetadata();
+}
+
+bool FontHDZero::readMetadata()
+{
     int width, height, channels;
-    uint8_t *image = stbi_load(path.c_str(), &width, &height, &channels, 0);
-    if (!image)
+    if (!stbi_info(this->path.c_str(), &width, &height, &channels))
     {
-        Log("Unable to load font file: ", path);
-        return;
+        LogError("Unable to load font file: ", this->path);
+        return false;
     }
     
     if ((width != OSD_CHAR_WIDTH_24 * CHARS_PER_FONT_ROW) && (width != OSD_CHAR_WIDTH_36 * CHARS_PER_FONT_ROW)) {
-        Log("Unexpected font size: %s\n", path);
-        stbi_image_free(image);
-        return;
+        LogError("Unexpected font size: ", this->path);
+        return false;
     }
 
     this->charWidth = width / CHARS_PER_FONT_ROW;
     this->charHeight = height / CHARS_PER_FONT_COLUMN;
-    charByteSize = this->charWidth * this->charHeight * BYTES_PER_PIXEL_RGBA;
-    charByteWidth = this->charWidth * BYTES_PER_PIXEL_RGBA;
 
     if ((this->charWidth == OSD_CHAR_WIDTH_24) && (this->charHeight != OSD_CHAR_HEIGHT_24)) {
-        Log("Unexpected image size: %s\n", path);
-        stbi_image_free(image);
-        return;
+        LogError("Unexpected image size: ", this->path);
+        return false;
     }
 
     if ((this->charWidth == OSD_CHAR_WIDTH_36) && (this->charHeight != OSD_CHAR_HEIGHT_36)) {
-        Log("Unexpected image size: %s\n", path);
+        LogError("Unexpected image size: ", this->path);
+        return false;
+    }
+
+    return true;
+}
+
+bool FontHDZero::decode()
+{
+    unsigned int charByteSize = 0, charByteWidth = 0;
+    int width, height, channels;
+    // Always expand to RGBA, so the colour key kernel works on whole 32 bit pixels
+    uint8_t *image = stbi_load(this->path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!image)
+    {
+        LogError("Unable to load font file: ", this->path);
+        return false;
+    }
+
+    if (width != static_cast<int>(this->charWidth * CHARS_PER_FONT_ROW) || height != static_cast<int>(this->charHeight * CHARS_PER_FONT_COLUMN)) {
+        LogError("Font file changed on disk: ", this->path);
         stbi_image_free(image);
-        return;
+        return false;
     }
+
+    charByteSize = this->charWidth * this->charHeight * BYTES_PER_PIXEL_RGBA;
+    charByteWidth = this->charWidth * BYTES_PER_PIXEL_RGBA;
+    uint8_t *glyphs = this->allocateSlab(CHARS_PER_FILE, charByteSize);
     
+    steady_clock::time_point start = steady_clock::now();
     for (int charIndex = 0; charIndex < CHARS_PER_FILE; charIndex++) {
-        std::vector<uint8_t> character(charByteSize);
-        int charHeigthIdx = charByteSize - charByteWidth;
+        uint8_t *character = glyphs + charIndex * charByteSize;
         int ix = (charIndex % CHARS_PER_FONT_ROW) * this->charWidth;
         int iy = (charIndex / CHARS_PER_FONT_ROW) * this->charHeight;
         for (unsigned int y = 0; y < this->charHeight; y++) {
-            for (unsigned int x = 0; x < this->charWidth; x++) {
-                
-                uint idx = ((iy + y) * channels * width) + ((ix + x) * channels);
-                uint8_t r = image[idx];
-                uint8_t g = image[idx + 1];
-                uint8_t b = image[idx + 2];
-                
-                if (r != 0x7f || g != 0x7f || b != 0x7f) {
-                    int cp = charHeigthIdx + (x * BYTES_PER_PIXEL_RGBA);
-                    character[cp]       = r;
-                    character[cp + 1]   = g;
-                    character[cp + 2]   = b;
-                    character[cp + 3]   = 0xff;
-                }
-            }
-            charHeigthIdx -= charByteWidth;
+            const uint8_t *row = image + (static_cast<size_t>(iy + y) * width + ix) * BYTES_PER_PIXEL_RGBA;
+            ColorKey::keyToAlpha(row, character + y * charByteWidth, this->charWidth);
         }
-        this->textures.push_back(character);
     }
+    LogDebug("Font ", this->name, " colour keyed (", ColorKey::getVariantName(), ") in ", duration_cast<microseconds>(steady_clock::now() - start).count(), " us");
+
     stbi_image_free(image);
+    return true;
 }
 
 int FontHDZero::getCols()
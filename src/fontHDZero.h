@@ -3,9 +3,12 @@
 #include "fontBase.h"
 
 class FontHDZero : public FontBase {
+    protected:
+        bool readMetadata();
+        bool decode();
+
     public:
-        FontHDZero() = default;
         FontHDZero(std::filesystem::path path);
         int getCols();
         int getRows();
-};
\ No newline at end of file
+};
@@ -0,0 +1,400 @@
+#include "fontTexture.h"
+
+#include <XPLMGraphics.h>
+#include <algorithm>
+#include <cstring>
+
+#include "helper.h"
+#include "workerPool.h"
+
+using namespace Helper;
+
+uint32_t FontTexture::nextId = 1;
+
+static void getGlFormat(glyphFormat_e glyphFormat, GLenum &internalFormat, GLenum &format)
+{
+    switch (glyphFormat) {
+        case GLYPH_FORMAT_LA8:
+        case GLYPH_FORMAT_SDF:
+            internalFormat = GL_RG8;
+            format = GL_RG;
+            break;
+        case GLYPH_FORMAT_RGTC2:
+            internalFormat = GL_COMPRESSED_RG_RGTC2;
+            format = GL_RG;
+            break;
+        case GLYPH_FORMAT_BC3:
+            internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            format = GL_RGBA;
+            break;
+        default:
+            internalFormat = GL_RGBA8;
+            format = GL_RGBA;
+            break;
+    }
+}
+
+FontTexture::FontTexture(std::shared_ptr<FontBase> font, unsigned int slots, textureFilter_e filter)
+{
+    GlyphView glyphs = font->getGlyphs();
+
+    this->font = font;
+    this->id = nextId++;
+    this->width = glyphs.getWidth();
+    this->height = glyphs.getHeight();
+    this->storageWidth = glyphs.getStorageWidth();
+    this->storageHeight = glyphs.getStorageHeight();
+    this->format = glyphs.getFormat();
+    this->sparse = slots > 0 && slots < glyphs.getCount();
+    this->layerCount = this->sparse ? slots : glyphs.getCount();
+
+    if (this->sparse) {
+        this->glyphSlots.assign(glyphs.getCount(), GLYPH_LAYER_NONE);
+        this->slotGlyphs.assign(slots, GLYPH_LAYER_NONE);
+        this->slotLastUsed.assign(slots, 0);
+    }
+
+    this->setFilter(filter);
+}
+
+FontTexture::~FontTexture()
+{
+    this->releasePixelBuffer();
+    if (this->texture != 0) {
+        glDeleteTextures(1, &this->texture);
+    }
+}
+
+void FontTexture::create(GlStateScope &state)
+{
+    GLenum internalFormat, format;
+    getGlFormat(this->format, internalFormat, format);
+
+    XPLMGenerateTextureNumbers(reinterpret_cast<int*>(&this->texture), 1);
+    state.bindTextureArray(this->texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, this->storageWidth, this->storageHeight, this->layerCount, 0, format, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    this->state = FONT_TEXTURE_READY;
+    if (!this->sparse) {
+        GlyphView glyphs = this->font->getGlyphs();
+        if (!this->startStreaming(glyphs)) {
+            // One upload per contiguous block (slab, cache mapping or bin bank), straight from the font's memory
+            state.setUnpackAlignment(1);
+            for (const glyphBlock_t &block : glyphs) {
+                this->upload(block.data, block.first, block.count);
+            }
+        }
+    }
+
+    LogDebug("Created ", this->sparse ? "sparse" : "full", " texture for font ", this->font->getName(), " with ", this->layerCount, " layers");
+}
+
+bool FontTexture::startStreaming(const GlyphView &glyphs)
+{
+    const size_t size = this->layerCount * glyphs.getStride();
+
+    glGenBuffers(1, &this->pixelBuffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->pixelBuffer);
+    // A persistent mapping lets the worker write without the buffer being mapped and unmapped on the main thread
+    this->persistentMapping = GLEW_ARB_buffer_storage;
+    if (this->persistentMapping) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+        this->mappedBuffer = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+    } else {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        this->mappedBuffer = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!this->mappedBuffer) {
+        LogWarning("Unable to map pixel buffer, uploading font ", this->font->getName(), " directly");
+        this->releasePixelBuffer();
+        return false;
+    }
+
+    // The font's glyphs stay loaded while streaming, see OSD::evictUnusedFonts
+    std::shared_ptr<FontBase> font = this->font;
+    uint8_t *target = this->mappedBuffer;
+    this->fill = WorkerPool::instance()->submit([font, target]() {
+        GlyphView glyphs = font->getGlyphs();
+        for (const glyphBlock_t &block : glyphs) {
+            memcpy(target + block.first * glyphs.getStride(), block.data, block.count * glyphs.getStride());
+        }
+        return true;
+    });
+
+    this->state = FONT_TEXTURE_FILLING;
+    this->uploadedLayers = 0;
+    return true;
+}
+
+void FontTexture::stream(GlStateScope &state)
+{
+    if (this->state == FONT_TEXTURE_FILLING) {
+        if (this->fill.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+        this->fill = std::shared_future<bool>();
+
+        if (!this->persistentMapping) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->pixelBuffer);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            this->mappedBuffer = nullptr;
+        }
+        this->state = FONT_TEXTURE_UPLOADING;
+    }
+
+    // With a pixel buffer bound, the data pointer is an offset into the buffer
+    const size_t stride = GlyphView::getLayerSize(this->format, this->width, this->height);
+    unsigned int count = std::min<unsigned int>(STREAM_LAYERS_PER_FRAME, this->layerCount - this->uploadedLayers);
+    state.bindTextureArray(this->texture);
+    state.setUnpackAlignment(1);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->pixelBuffer);
+    this->upload(reinterpret_cast<const uint8_t*>(this->uploadedLayers * stride), this->uploadedLayers, count);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    this->uploadedLayers += count;
+
+    if (this->uploadedLayers == this->layerCount) {
+        this->releasePixelBuffer();
+        if (this->mipmapsDirty) {
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            this->mipmapsDirty = false;
+        }
+        this->state = FONT_TEXTURE_READY;
+        LogDebug("Font texture ", this->font->getName(), " streamed");
+    }
+}
+
+void FontTexture::releasePixelBuffer()
+{
+    if (this->fill.valid()) {
+        this->fill.wait();
+        this->fill = std::shared_future<bool>();
+    }
+
+    if (this->pixelBuffer != 0) {
+        if (this->mappedBuffer) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->pixelBuffer);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            this->mappedBuffer = nullptr;
+        }
+        glDeleteBuffers(1, &this->pixelBuffer);
+        this->pixelBuffer = 0;
+    }
+}
+
+void FontTexture::update(GlStateScope &state)
+{
+    if (this->state == FONT_TEXTURE_PENDING) {
+        this->create(state);
+    } else if (this->state != FONT_TEXTURE_READY) {
+        this->stream(state);
+    }
+
+    if (this->filterChanged) {
+        state.bindTextureArray(this->texture);
+        this->applyFilter();
+        this->filterChanged = false;
+    }
+}
+
+bool FontTexture::isReady()
+{
+    return this->state == FONT_TEXTURE_READY;
+}
+
+bool FontTexture::isStreaming()
+{
+    return this->state != FONT_TEXTURE_READY;
+}
+
+void FontTexture::upload(const uint8_t *data, unsigned int layer, unsigned int count)
+{
+    GLenum internalFormat, format;
+    getGlFormat(this->format, internalFormat, format);
+
+    // Expects the texture bound and an unpack alignment of 1, LA8 rows are not necessarily 4 byte aligned
+    if (GlyphView::isCompressed(this->format)) {
+        size_t size = count * GlyphView::getLayerSize(this->format, this->width, this->height);
+        glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, this->storageWidth, this->storageHeight, count, internalFormat, size, data);
+    } else {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, this->width, this->height, count, format, GL_UNSIGNED_BYTE, data);
+    }
+    this->mipmapsDirty = this->hasMipmaps;
+}
+
+void FontTexture::setFilter(textureFilter_e filter)
+{
+    // Mipmaps can't be generated for compressed formats
+    if (filter == TEXTURE_FILTER_TRILINEAR && GlyphView::isCompressed(this->format)) {
+        filter = TEXTURE_FILTER_LINEAR;
+    }
+    this->filter = filter;
+    this->filterChanged = true;
+}
+
+void FontTexture::applyFilter()
+{
+    const textureFilter_e filter = this->filter;
+
+    // Only level 0 is allocated by glTexImage3D, mip levels cost memory and a pass over all layers, so they are built on demand
+    if (filter == TEXTURE_FILTER_TRILINEAR && !this->hasMipmaps) {
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 1000);
+        this->hasMipmaps = true;
+        // Streamed textures build them once the last layer is in
+        if (this->isReady()) {
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        } else {
+            this->mipmapsDirty = true;
+        }
+    }
+
+    // Without mipmaps the texture is only complete with a max level of 0
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, filter == TEXTURE_FILTER_TRILINEAR ? 1000 : 0);
+
+    switch (filter) {
+        case TEXTURE_FILTER_NEAREST:
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            break;
+        case TEXTURE_FILTER_TRILINEAR:
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            break;
+        default:
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            break;
+    }
+}
+
+GLuint FontTexture::getTexture()
+{
+    return this->texture;
+}
+
+void FontTexture::beginFrame(GlStateScope &state)
+{
+    this->frame++;
+    state.bindTextureArray(this->texture);
+    if (this->sparse) {
+        state.setUnpackAlignment(1);
+    }
+}
+
+int FontTexture::allocateSlot()
+{
+    // Slots drawn in the current frame must not be recycled, they are still referenced
+    int slot = GLYPH_LAYER_NONE;
+    uint32_t oldest = this->frame;
+    for (size_t i = 0; i < this->slotGlyphs.size(); i++) {
+        if (this->slotGlyphs[i] == GLYPH_LAYER_NONE) {
+            return i;
+        }
+
+        if (this->slotLastUsed[i] < oldest) {
+            oldest = this->slotLastUsed[i];
+            slot = i;
+        }
+    }
+
+    if (slot != GLYPH_LAYER_NONE) {
+        this->glyphSlots[this->slotGlyphs[slot]] = GLYPH_LAYER_NONE;
+    }
+    return slot;
+}
+
+int FontTexture::getLayer(uint16_t glyph)
+{
+    if (!this->sparse) {
+        return glyph < this->layerCount ? glyph : GLYPH_LAYER_NONE;
+    }
+
+    if (glyph >= this->glyphSlots.size()) {
+        return GLYPH_LAYER_NONE;
+    }
+
+    int slot = this->glyphSlots[glyph];
+    if (slot == GLYPH_LAYER_NONE) {
+        // Glyph data is only needed on a miss, the font stays loaded as long as it is active
+        if (!this->font->isLoaded()) {
+            return GLYPH_LAYER_NONE;
+        }
+
+        slot = this->allocateSlot();
+        if (slot == GLYPH_LAYER_NONE) {
+            if (!this->slotsExhausted) {
+                LogWarning("Glyph cache of font ", this->font->getName(), " is too small for the current screen");
+                this->slotsExhausted = true;
+            }
+            return GLYPH_LAYER_NONE;
+        }
+
+        this->upload(this->font->getGlyphs().getGlyph(glyph), slot, 1);
+        this->glyphSlots[glyph] = slot;
+        this->slotGlyphs[slot] = glyph;
+    }
+
+    this->slotLastUsed[slot] = this->frame;
+    return slot;
+}
+
+void FontTexture::endFrame()
+{
+    if (this->mipmapsDirty) {
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        this->mipmapsDirty = false;
+    }
+}
+
+uint32_t FontTexture::getId()
+{
+    return this->id;
+}
+
+std::string FontTexture::getFontName()
+{
+    return this->font->getName();
+}
+
+unsigned int FontTexture::getWidth()
+{
+    return this->width;
+}
+
+unsigned int FontTexture::getHeight()
+{
+    return this->height;
+}
+
+unsigned int FontTexture::getStorageWidth()
+{
+    return this->storageWidth;
+}
+
+unsigned int FontTexture::getStorageHeight()
+{
+    return this->storageHeight;
+}
+
+glyphFormat_e FontTexture::getFormat()
+{
+    return this->format;
+}
+
+bool FontTexture::isSparse()
+{
+    return this->sparse;
+}
+
+size_t FontTexture::getByteSize()
+{
+    size_t size = this->layerCount * GlyphView::getLayerSize(this->format, this->width, this->height);
+    // A full mip chain adds a third, counted before the texture is created as well
+    return this->hasMipmaps || this->filter == TEXTURE_FILTER_TRILINEAR ? size + size / 3 : size;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "platform.h"
+
+#include <GL/glew.h>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fontBase.h"
+#include "glStateScope.h"
+
+#define GLYPH_LAYER_NONE -1
+// Layers copied from the pixel buffer into the texture per frame while streaming
+#define STREAM_LAYERS_PER_FRAME 64
+
+typedef enum {
+    TEXTURE_FILTER_NEAREST = 0,     // Pixel perfect
+    TEXTURE_FILTER_LINEAR = 1,
+    TEXTURE_FILTER_TRILINEAR = 2,   // Mipmapped, for heavily downscaled OSDs
+} textureFilter_e;
+
+typedef enum {
+    FONT_TEXTURE_PENDING,       // Created by the first update(), inside the OSD's GL state
+    FONT_TEXTURE_FILLING,       // A worker copies the glyphs into the pixel buffer
+    FONT_TEXTURE_UPLOADING,     // Layers are copied from the pixel buffer, a few per frame
+    FONT_TEXTURE_READY,
+} fontTextureState_e;
+
+// Texture array holding the glyphs of one font. Either every glyph gets its own 
+// layer, or (sparse) glyphs are uploaded into a fixed number of slots the first 
+// time they are drawn and the least recently used one is recycled.
+// Full textures are streamed: a worker fills a pixel buffer, which is then 
+// uploaded over several frames. The texture must not be drawn before isReady().
+// All GL work happens in update() and between beginFrame() and endFrame(), which 
+// are only called while rendering, so loading a font never touches GL.
+class FontTexture {
+    private:
+        static uint32_t nextId;
+
+        std::shared_ptr<FontBase> font;
+        uint32_t id = 0;
+        GLuint texture = 0;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        unsigned int storageWidth = 0;
+        unsigned int storageHeight = 0;
+        unsigned int layerCount = 0;
+        glyphFormat_e format = GLYPH_FORMAT_RGBA8;
+        textureFilter_e filter = TEXTURE_FILTER_LINEAR;
+        bool filterChanged = false;
+        bool hasMipmaps = false;
+        bool mipmapsDirty = false;
+        fontTextureState_e state = FONT_TEXTURE_PENDING;
+
+        GLuint pixelBuffer = 0;
+        uint8_t *mappedBuffer = nullptr;
+        bool persistentMapping = false;
+        std::shared_future<bool> fill;
+        unsigned int uploadedLayers = 0;
+
+        bool sparse = false;
+        uint32_t frame = 0;
+        bool slotsExhausted = false;
+        std::vector<int> glyphSlots;
+        std::vector<int> slotGlyphs;
+        std::vector<uint32_t> slotLastUsed;
+
+        void create(GlStateScope &state);
+        void applyFilter();
+        void upload(const uint8_t *data, unsigned int layer, unsigned int count);
+        int allocateSlot();
+        bool startStreaming(const GlyphView &glyphs);
+        void stream(GlStateScope &state);
+        void releasePixelBuffer();
+
+    public:
+        // slots == 0 uploads the whole font
+        FontTexture(std::shared_ptr<FontBase> font, unsigned int slots, textureFilter_e filter);
+        ~FontTexture();
+        FontTexture(FontTexture const&) = delete;
+        FontTexture& operator =(FontTexture const&) = delete;
+
+        // Applied by the next update()
+        void setFilter(textureFilter_e filter);
+        void update(GlStateScope &state);
+        bool isReady();
+        bool isStreaming();
+        // Binds the texture, sparse glyphs are uploaded by getLayer() until endFrame()
+        void beginFrame(GlStateScope &state);
+        int getLayer(uint16_t glyph);
+        void endFrame();
+
+        // Unique per texture, unlike the address
+        uint32_t getId();
+        GLuint getTexture();
+        std::string getFontName();
+        unsigned int getWidth();
+        unsigned int getHeight();
+        unsigned int getStorageWidth();
+        unsigned int getStorageHeight();
+        glyphFormat_e getFormat();
+        size_t getByteSize();
+        bool isSparse();
+};
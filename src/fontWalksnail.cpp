@@ -16,58 +16,71 @@
 
 using namespace Helper;
 
-FontWalksnail::FontWalksnail(std::filesystem::path path)
+FontWalksnail::FontWalksnail(std::filesystem::path path) : FontBase(path)
 {
   this->name = path.filename().replace_extension();
+  this->valid = this->readMetadata();
+}
 
-  int width, height, charByteSize, channels;
-  int charSize, charByteWidth;
+bool FontWalksnail::readMetadata()
+{
+  int width, height, channels;
 
-  uint8_t *image = stbi_load(path.c_str(), &width, &height, &channels, 0);
-  if (!image)
+  if (!stbi_info(this->path.c_str(), &width, &height, &channels))
   {
-    Log("Unable to load font file: ", path);
-    return;
+    LogError("Unable to load font file: ", this->path);
+    return false;
   }
 
   if ((width != OSD_CHAR_WIDTH_24) && (width != OSD_CHAR_WIDTH_36))
   {
-    Log("Unexpected image size: %s\n", path);
-    return;
+    LogError("Unexpected image size: ", this->path);
+    return false;
   }
   
   this->charWidth = width;
   this->charHeight = height / CHARS_PER_FILE;
-  charByteSize = this->charWidth * this->charHeight * BYTES_PER_PIXEL_RGBA;
-  charByteWidth = this->charWidth * BYTES_PER_PIXEL_RGBA;
 
   if ((this->charWidth == OSD_CHAR_WIDTH_24) && (this->charHeight != OSD_CHAR_HEIGHT_24))
   {
-    Log("Unexpected image size: %s\n", path);
-    stbi_image_free(image);
-    return;
+    LogError("Unexpected image size: ", this->path);
+    return false;
   }
 
   if ((this->charWidth == OSD_CHAR_WIDTH_36) && (this->charHeight != OSD_CHAR_HEIGHT_36))
   {
-    Log("Unexpected image size: %s\n", path);
-    stbi_image_free(image);
-    return;
-  }  
+    LogError("Unexpected image size: ", this->path);
+    return false;
+  }
+
+  return true;
+}
 
-  for (int charIndex = 0; charIndex < CHARS_PER_FILE; charIndex++)
+bool FontWalksnail::decode()
+{
+  int width, height, channels;
+  unsigned int charByteSize;
+
+  uint8_t *image = stbi_load(this->path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+  if (!image)
   {
-    // Flip character bitmap to convert to OpenGl coords (0, 0) = left down
-    int charBegin = charIndex * charByteSize;
-    std::vector<uint8_t> texture(charByteSize);
-    int targetIdx = charByteSize - charByteWidth;
-    for (unsigned int j = 0; j < charByteSize; j += charByteWidth) {
-      std::copy_n(image + charBegin + j, charByteWidth, texture.begin() + targetIdx);
-      targetIdx -= charByteWidth;
-    }
-    this->textures.push_back(texture);
+    LogError("Unable to load font file: ", this->path);
+    return false;
   }
+
+  if (width != static_cast<int>(this->charWidth) || height != static_cast<int>(this->charHeight * CHARS_PER_FILE))
+  {
+    LogError("Font file changed on disk: ", this->path);
+    stbi_image_free(image);
+    return false;
+  }
+  
+  // The sheet is a single column of glyphs, so it already is in layer order
+  charByteSize = this->charWidth * this->charHeight * BYTES_PER_PIXEL_RGBA;
+  uint8_t *glyphs = this->allocateSlab(CHARS_PER_FILE, charByteSize);
+  std::copy_n(image, static_cast<size_t>(CHARS_PER_FILE) * charByteSize, glyphs);
   stbi_image_free(image);
+  return true;
 }
 
 int FontWalksnail::getCols()
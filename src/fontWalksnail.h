@@ -3,9 +3,12 @@
 #include "fontBase.h"
 
 class FontWalksnail : public FontBase {
+    protected:
+        bool readMetadata();
+        bool decode();
+
     public:
-        FontWalksnail() = default;
         FontWalksnail(std::filesystem::path path);
         int getCols();
         int getRows();
-};
\ No newline at end of file
+};
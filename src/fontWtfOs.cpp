@@ -1,53 +1,69 @@
 #include "fontWtfOs.h"
 
-#include <fstream>
-
 #include "helper.h"
 
-#define CHAR_WIDTH			  36
-#define CHAR_HEIGHT			  54
+#define WTFOS_CHAR_WIDTH      36
+#define WTFOS_CHAR_HEIGHT     54
 #define CHARS_PER_FILE		  256
 
-#define CHAR_SIZE (CHAR_HEIGHT * CHAR_WIDTH * BYTES_PER_PIXEL_RGBA)
+#define CHAR_SIZE (WTFOS_CHAR_HEIGHT * WTFOS_CHAR_WIDTH * BYTES_PER_PIXEL_RGBA)
 #define FONT_FILE_SIZE (CHAR_SIZE * CHARS_PER_FILE)
-#define CHAR_BYTE_WIDTH (CHAR_WIDTH * BYTES_PER_PIXEL_RGBA)
+
+#define FILE_NAME_BANK_1 "font_inav.bin"
+#define FILE_NAME_BANK_2 "font_inav_2.bin"
 
 using namespace Helper;
 
-FontWtfOS::FontWtfOS(std::filesystem::path path)
+FontWtfOS::FontWtfOS(std::filesystem::path path) : FontBase(path)
 {
     this->name = path.filename();
-    
-    std::filesystem::path fileNameBank1 = path; 
-    std::filesystem::path fileNameBank2 = path;
-    fileNameBank1.append("font_inav.bin");
-    fileNameBank2.append("font_inav_2.bin");
-
-    std::vector<uint8_t> bank1 = this->loadBin(fileNameBank1);
-    std::vector<uint8_t> bank2 = this->loadBin(fileNameBank2);
-
-    if (bank1.empty() || bank2.empty()) {
-        Log("Unable to load font file:", this->name);
-        return;
-    }
+    this->valid = this->readMetadata();
+}
 
-    this->charWidth = CHAR_WIDTH;
-    this->charHeight = CHAR_HEIGHT;
+bool FontWtfOS::readMetadata()
+{
+    for (const char *bankName : {FILE_NAME_BANK_1, FILE_NAME_BANK_2}) {
+        std::filesystem::path bankPath = this->path / bankName;
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(bankPath, error);
+        if (error) {
+            LogError("Unable to open file: ", bankPath);
+            return false;
+        }
 
-    std::vector<uint8_t> *bank;
-    for (int charIndex = 0; charIndex < CHARS_PER_FILE * 2; charIndex++)
-    {
-        bank = charIndex >= CHARS_PER_FILE ? &bank2 : &bank1;
-        // Flip character bitmap to convert to OpenGl coords (0, 0) = left down
-        int charBegin = charIndex % CHARS_PER_FILE * CHAR_SIZE;
-        std::vector<uint8_t> texture(CHAR_SIZE);
-        int targetIdx = CHAR_SIZE - CHAR_BYTE_WIDTH;
-        for (int j = 0; j < CHAR_SIZE; j += CHAR_BYTE_WIDTH) {
-            std::copy_n(bank->begin() + charBegin + j, CHAR_BYTE_WIDTH, texture.begin() + targetIdx);
-            targetIdx -= CHAR_BYTE_WIDTH;
+        if (size != FONT_FILE_SIZE) {
+            LogError("Incorrect file size: ", bankPath);
+            return false;
         }
-        this->textures.push_back(texture);
     }
+
+    this->charWidth = WTFOS_CHAR_WIDTH;
+    this->charHeight = WTFOS_CHAR_HEIGHT;
+    return true;
+}
+
+bool FontWtfOS::decode()
+{
+    // The bank files already hold raw RGBA glyphs, they are mapped and uploaded 
+    // as they are.
+    if (!this->mapBank(this->path / FILE_NAME_BANK_1, 0) || !this->mapBank(this->path / FILE_NAME_BANK_2, CHARS_PER_FILE)) {
+        LogError("Unable to load font file: ", this->name);
+        return false;
+    }
+
+    this->glyphCount = CHARS_PER_FILE * 2;
+    this->glyphByteSize = CHAR_SIZE;
+    return true;
+}
+
+std::vector<std::filesystem::path> FontWtfOS::getSourceFiles()
+{
+    return {this->path / FILE_NAME_BANK_1, this->path / FILE_NAME_BANK_2};
+}
+
+bool FontWtfOS::isCacheable()
+{
+    return false;
 }
 
 int FontWtfOS::getCols()
@@ -60,32 +76,22 @@ int FontWtfOS::getRows()
     return 22;
 }
 
-std::vector<uint8_t> FontWtfOS::loadBin(std::filesystem::path path)
+bool FontWtfOS::mapBank(std::filesystem::path path, unsigned int firstGlyph)
 {
-    std::vector<uint8_t> font = std::vector<uint8_t>(FONT_FILE_SIZE);
-
-    std::fstream file(path, std::fstream::in | std::fstream::binary | std::fstream::ate);
-    int size = 0;
-
-    if (!file.is_open())
+    std::unique_ptr<MappedFile> file = std::make_unique<MappedFile>();
+    if (!file->open(path))
     {
-        Log("Unable to open file: %s\n", path);
-        return font;
+        LogError("Unable to open file: ", path);
+        return false;
     }
 
-    size = static_cast<int>(file.tellg());
-    if (size != FONT_FILE_SIZE)
+    if (file->getSize() != FONT_FILE_SIZE)
     {
-        Log("Incorrect file size: %s\n", path);
-        file.close();
-        return font;
+        LogError("Incorrect file size: ", path);
+        return false;
     }
 
-    file.seekg(0);
-    file.read((char*)font.data(), size);
-
-    file.close();
-
-    return font;
+    this->glyphBlocks.push_back({file->getData(), firstGlyph, CHARS_PER_FILE});
+    this->mappedFiles.push_back(std::move(file));
+    return true;
 }
-
@@ -4,10 +4,16 @@
 
 class FontWtfOS : public FontBase {
     private:
-        std::vector<uint8_t> loadBin(std::filesystem::path path);
+        bool mapBank(std::filesystem::path path, unsigned int firstGlyph);
+    
+    protected:
+        bool readMetadata();
+        bool decode();
+        std::vector<std::filesystem::path> getSourceFiles();
+        bool isCacheable();
+
     public:
-        FontWtfOS() = default;
         FontWtfOS(std::filesystem::path path);
         int getCols();
         int getRows();
-};
\ No newline at end of file
+};
@@ -0,0 +1,188 @@
+#include "glStateScope.h"
+
+#include "XPLMGraphics.h"
+
+#include <algorithm>
+#include <iterator>
+
+static const GLint DEFAULT_BLEND[4] = {GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA};
+
+GlStateScope::GlStateScope()
+{
+    // No fog, one texture unit, no lighting, no alpha test, alpha blending, no depth test or writes
+    XPLMSetGraphicsState(0, 1, 0, 0, 1, 0, 0);
+}
+
+GlStateScope::~GlStateScope()
+{
+    if (this->textureArray > 0) {
+        this->activeTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    if (this->textureUnitChanged && this->currentActiveTexture != GL_TEXTURE0) {
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    if (this->vertexArray > 0) {
+        glBindVertexArray(0);
+    }
+
+    if (this->program > 0) {
+        glUseProgram(0);
+    }
+
+    if (this->unpackAlignmentSaved && this->unpackAlignment != this->previousUnpackAlignment) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, this->previousUnpackAlignment);
+    }
+
+    if (this->scissorSaved) {
+        glScissor(this->previousScissorBox[0], this->previousScissorBox[1], this->previousScissorBox[2], this->previousScissorBox[3]);
+        if (this->previousScissorTest && !this->scissorTest) {
+            glEnable(GL_SCISSOR_TEST);
+        } else if (!this->previousScissorTest && this->scissorTest) {
+            glDisable(GL_SCISSOR_TEST);
+        }
+    }
+
+    if (this->framebufferSaved && this->framebuffer != this->previousFramebuffer) {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->previousFramebuffer);
+    }
+    if (this->viewportChanged) {
+        glViewport(this->previousViewport[0], this->previousViewport[1], this->previousViewport[2], this->previousViewport[3]);
+    }
+
+    if (this->blend[0] != -1 && !std::equal(std::begin(this->blend), std::end(this->blend), DEFAULT_BLEND)) {
+        glBlendFuncSeparate(DEFAULT_BLEND[0], DEFAULT_BLEND[1], DEFAULT_BLEND[2], DEFAULT_BLEND[3]);
+    }
+}
+
+void GlStateScope::useProgram(GLuint program)
+{
+    if (this->program != static_cast<GLint>(program)) {
+        glUseProgram(program);
+        this->program = program;
+    }
+}
+
+void GlStateScope::bindVertexArray(GLuint vertexArray)
+{
+    if (this->vertexArray != static_cast<GLint>(vertexArray)) {
+        glBindVertexArray(vertexArray);
+        this->vertexArray = vertexArray;
+    }
+}
+
+void GlStateScope::activeTexture(GLenum unit)
+{
+    if (this->currentActiveTexture != static_cast<GLint>(unit)) {
+        glActiveTexture(unit);
+        this->currentActiveTexture = unit;
+        this->textureUnitChanged = true;
+    }
+}
+
+void GlStateScope::bindTextureArray(GLuint texture)
+{
+    this->activeTexture(GL_TEXTURE0);
+    if (this->textureArray != static_cast<GLint>(texture)) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        this->textureArray = texture;
+    }
+}
+
+void GlStateScope::bindTexture2d(GLuint texture, int unit)
+{
+    XPLMBindTexture2d(texture, unit);
+    // XPLM may leave another unit active
+    this->currentActiveTexture = -1;
+    this->textureUnitChanged = true;
+}
+
+void GlStateScope::setBlendFunc(GLenum src, GLenum dst)
+{
+    this->setBlendFuncSeparate(src, dst, src, dst);
+}
+
+void GlStateScope::setBlendFuncSeparate(GLenum srcColor, GLenum dstColor, GLenum srcAlpha, GLenum dstAlpha)
+{
+    const GLint blend[4] = {static_cast<GLint>(srcColor), static_cast<GLint>(dstColor), static_cast<GLint>(srcAlpha), static_cast<GLint>(dstAlpha)};
+    if (!std::equal(std::begin(blend), std::end(blend), this->blend)) {
+        glBlendFuncSeparate(srcColor, dstColor, srcAlpha, dstAlpha);
+        std::copy(std::begin(blend), std::end(blend), this->blend);
+    }
+}
+
+void GlStateScope::saveScissor()
+{
+    if (!this->scissorSaved) {
+        this->previousScissorTest = glIsEnabled(GL_SCISSOR_TEST);
+        this->scissorTest = this->previousScissorTest;
+        glGetIntegerv(GL_SCISSOR_BOX, this->previousScissorBox);
+        this->scissorSaved = true;
+    }
+}
+
+void GlStateScope::setScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    this->saveScissor();
+    if (!this->scissorTest) {
+        glEnable(GL_SCISSOR_TEST);
+        this->scissorTest = GL_TRUE;
+    }
+    glScissor(x, y, width, height);
+}
+
+void GlStateScope::disableScissor()
+{
+    this->saveScissor();
+    if (this->scissorTest) {
+        glDisable(GL_SCISSOR_TEST);
+        this->scissorTest = GL_FALSE;
+    }
+}
+
+void GlStateScope::saveViewport()
+{
+    if (!this->viewportSaved) {
+        glGetIntegerv(GL_VIEWPORT, this->previousViewport);
+        this->viewportSaved = true;
+    }
+}
+
+void GlStateScope::bindFramebuffer(GLuint framebuffer, GLsizei width, GLsizei height)
+{
+    if (!this->framebufferSaved) {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &this->previousFramebuffer);
+        this->framebuffer = this->previousFramebuffer;
+        this->framebufferSaved = true;
+    }
+    this->saveViewport();
+
+    if (this->framebuffer != static_cast<GLint>(framebuffer)) {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        this->framebuffer = framebuffer;
+    }
+    glViewport(0, 0, width, height);
+    this->viewportChanged = true;
+}
+
+void GlStateScope::setUnpackAlignment(GLint alignment)
+{
+    if (!this->unpackAlignmentSaved) {
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &this->previousUnpackAlignment);
+        this->unpackAlignment = this->previousUnpackAlignment;
+        this->unpackAlignmentSaved = true;
+    }
+
+    if (this->unpackAlignment != alignment) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        this->unpackAlignment = alignment;
+    }
+}
+
+const GLint *GlStateScope::getViewport()
+{
+    this->saveViewport();
+    return this->previousViewport;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// GL state of one OSD pass. Sets the fixed function state through XPLM, which
+// caches it, and tracks the bindings the pass changes. Nothing is known about
+// the state X-Plane or other plugins left behind, so the first call of each kind
+// always reaches the driver and later ones are skipped if they would not change
+// anything. When the scope ends, whatever the pass changed is put back to
+// X-Plane's defaults: no program, no vertex array, unit 0 active, no texture
+// array bound and the standard alpha blending. Scissor, framebuffer, viewport
+// and unpack alignment have no defaults, they are queried when a pass first
+// changes them and restored to the queried values.
+class GlStateScope {
+    private:
+        GLint program = -1;
+        GLint vertexArray = -1;
+        GLint currentActiveTexture = -1;
+        bool textureUnitChanged = false;
+        GLint textureArray = -1;
+        // Source and destination factors for colour, then alpha
+        GLint blend[4] = {-1, -1, -1, -1};
+
+        bool scissorSaved = false;
+        GLboolean previousScissorTest = GL_FALSE;
+        GLboolean scissorTest = GL_FALSE;
+        GLint previousScissorBox[4] = {};
+        bool framebufferSaved = false;
+        GLint previousFramebuffer = 0;
+        GLint framebuffer = 0;
+        bool viewportSaved = false;
+        GLint previousViewport[4] = {};
+        bool viewportChanged = false;
+        bool unpackAlignmentSaved = false;
+        GLint previousUnpackAlignment = 4;
+        GLint unpackAlignment = 4;
+
+        void saveScissor();
+        void saveViewport();
+
+    public:
+        GlStateScope();
+        ~GlStateScope();
+
+        GlStateScope(const GlStateScope&) = delete;
+        GlStateScope &operator=(const GlStateScope&) = delete;
+
+        void useProgram(GLuint program);
+        void bindVertexArray(GLuint vertexArray);
+        void activeTexture(GLenum unit);
+        // Always on unit 0, glyphs are sampled from there
+        void bindTextureArray(GLuint texture);
+        // 2D textures go through XPLM, which tracks their bindings itself
+        void bindTexture2d(GLuint texture, int unit);
+        void setBlendFunc(GLenum src, GLenum dst);
+        void setBlendFuncSeparate(GLenum srcColor, GLenum dstColor, GLenum srcAlpha, GLenum dstAlpha);
+        void setScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+        void disableScissor();
+        // Draw framebuffer and viewport, both are put back together
+        void bindFramebuffer(GLuint framebuffer, GLsizei width, GLsizei height);
+        void setUnpackAlignment(GLint alignment);
+        // X-Plane's viewport, in pixels of the framebuffer it draws into
+        const GLint *getViewport();
+};
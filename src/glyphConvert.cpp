@@ -0,0 +1,405 @@
+#include "glyphConvert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "workerPool.h"
+
+#define BLOCK_PIXELS (COMPRESSED_BLOCK_SIZE * COMPRESSED_BLOCK_SIZE)
+#define SDF_INFINITY 1e20
+
+namespace GlyphConvert {
+
+    bool isGrayscale(const GlyphView &glyphs)
+    {
+        const size_t pixels = static_cast<size_t>(glyphs.getWidth()) * glyphs.getHeight();
+        for (unsigned int i = 0; i < glyphs.getCount(); i++) {
+            const uint8_t *glyph = glyphs.getGlyph(i);
+            for (size_t p = 0; p < pixels; p++) {
+                const uint8_t *pixel = glyph + p * BYTES_PER_PIXEL_RGBA;
+                if (pixel[3] != 0 && (pixel[0] != pixel[1] || pixel[0] != pixel[2])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void toLuminanceAlpha(const GlyphView &glyphs, uint8_t *dst)
+    {
+        const size_t pixels = static_cast<size_t>(glyphs.getWidth()) * glyphs.getHeight();
+        for (unsigned int i = 0; i < glyphs.getCount(); i++) {
+            const uint8_t *glyph = glyphs.getGlyph(i);
+            uint8_t *target = dst + i * pixels * BYTES_PER_PIXEL_LA;
+            for (size_t p = 0; p < pixels; p++) {
+                target[p * BYTES_PER_PIXEL_LA] = glyph[p * BYTES_PER_PIXEL_RGBA];
+                target[p * BYTES_PER_PIXEL_LA + 1] = glyph[p * BYTES_PER_PIXEL_RGBA + 3];
+            }
+        }
+    }
+
+    // Copies a 4x4 block out of a glyph, pixels outside the glyph are transparent black
+    static void fetchBlock(const uint8_t *glyph, unsigned int width, unsigned int height, size_t bytesPerPixel, unsigned int bx, unsigned int by, uint8_t *block)
+    {
+        memset(block, 0, BLOCK_PIXELS * bytesPerPixel);
+        for (unsigned int y = 0; y < COMPRESSED_BLOCK_SIZE; y++) {
+            unsigned int py = by * COMPRESSED_BLOCK_SIZE + y;
+            if (py >= height) {
+                break;
+            }
+            for (unsigned int x = 0; x < COMPRESSED_BLOCK_SIZE; x++) {
+                unsigned int px = bx * COMPRESSED_BLOCK_SIZE + x;
+                if (px >= width) {
+                    break;
+                }
+                memcpy(block + (y * COMPRESSED_BLOCK_SIZE + x) * bytesPerPixel, glyph + (static_cast<size_t>(py) * width + px) * bytesPerPixel, bytesPerPixel);
+            }
+        }
+    }
+
+    // Encodes one channel of a 4x4 block as BC4 (8 bytes), always using the 8 value interpolation mode
+    static void encodeBc4Block(const uint8_t *block, size_t bytesPerPixel, size_t channel, uint8_t *dst)
+    {
+        uint8_t values[BLOCK_PIXELS];
+        for (int p = 0; p < BLOCK_PIXELS; p++) {
+            values[p] = block[p * bytesPerPixel + channel];
+        }
+
+        uint8_t min = *std::min_element(values, values + BLOCK_PIXELS);
+        uint8_t max = *std::max_element(values, values + BLOCK_PIXELS);
+
+        dst[0] = max;
+        dst[1] = min;
+        memset(dst + 2, 0, 6);
+        if (max == min) {
+            return;
+        }
+
+        // Palette for endpoint0 > endpoint1: 0 = max, 1 = min, 2..7 = interpolated from max to min
+        int palette[8];
+        palette[0] = max;
+        palette[1] = min;
+        for (int i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * max + i * min) / 7;
+        }
+
+        uint64_t bits = 0;
+        for (int p = 0; p < BLOCK_PIXELS; p++) {
+            int best = 0;
+            int bestError = 256;
+            for (int i = 0; i < 8; i++) {
+                int error = std::abs(values[p] - palette[i]);
+                if (error < bestError) {
+                    bestError = error;
+                    best = i;
+                }
+            }
+            bits |= static_cast<uint64_t>(best) << (p * 3);
+        }
+
+        for (int i = 0; i < 6; i++) {
+            dst[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+        }
+    }
+
+    static uint16_t packRgb565(const float *color)
+    {
+        int r = std::clamp(static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+        int g = std::clamp(static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+        int b = std::clamp(static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    static void unpackRgb565(uint16_t color, int *rgb)
+    {
+        rgb[0] = ((color >> 11) & 0x1f) * 255 / 31;
+        rgb[1] = ((color >> 5) & 0x3f) * 255 / 63;
+        rgb[2] = (color & 0x1f) * 255 / 31;
+    }
+
+    // Encodes the colour of a 4x4 RGBA block as BC1 (8 bytes) in 4 colour mode. Endpoints are the 
+    // extremes along the principal axis of the visible pixels, transparent pixels don't matter.
+    static void encodeBc1Block(const uint8_t *block, uint8_t *dst)
+    {
+        float mean[3] = {0.0f, 0.0f, 0.0f};
+        int visible = 0;
+        for (int p = 0; p < BLOCK_PIXELS; p++) {
+            if (block[p * BYTES_PER_PIXEL_RGBA + 3] == 0) {
+                continue;
+            }
+            for (int c = 0; c < 3; c++) {
+                mean[c] += block[p * BYTES_PER_PIXEL_RGBA + c];
+            }
+            visible++;
+        }
+
+        memset(dst, 0, 8);
+        if (visible == 0) {
+            return;
+        }
+
+        for (int c = 0; c < 3; c++) {
+            mean[c] /= visible;
+        }
+
+        float covariance[6] = {0.0f};
+        for (int p = 0; p < BLOCK_PIXELS; p++) {
+            const uint8_t *pixel = block + p * BYTES_PER_PIXEL_RGBA;
+            if (pixel[3] == 0) {
+                continue;
+            }
+            float r = pixel[0] - mean[0];
+            float g = pixel[1] - mean[1];
+            float b = pixel[2] - mean[2];
+            covariance[0] += r * r;
+            covariance[1] += r * g;
+            covariance[2] += r * b;
+            covariance[3] += g * g;
+            covariance[4] += g * b;
+            covariance[5] += b * b;
+        }
+
+        // A few power iterations are enough to find the dominant axis of 16 pixels
+        float axis[3] = {1.0f, 1.0f, 1.0f};
+        for (int i = 0; i < 4; i++) {
+            float x = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+            float y = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+            float z = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+            float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+            if (length < 1e-6f) {
+                break;
+            }
+            axis[0] = x / length;
+            axis[1] = y / length;
+            axis[2] = z / length;
+        }
+
+        float minDot = 1e30f;
+        float maxDot = -1e30f;
+        int minPixel = 0;
+        int maxPixel = 0;
+        for (int p = 0; p < BLOCK_PIXELS; p++) {
+            const uint8_t *pixel = block + p * BYTES_PER_PIXEL_RGBA;
+            if (pixel[3] == 0) {
+                continue;
+            }
+            float dot = pixel[0] * axis[0] + pixel[1] * axis[1] + pixel[2] * axis[2];
+            if (dot < minDot) {
+                minDot = dot;
+                minPixel = p;
+            }
+            if (dot > maxDot) {
+                maxDot = dot;
+                maxPixel = p;
+            }
+        }
+
+        float maxColor[3];
+        float minColor[3];
+        for (int c = 0; c < 3; c++) {
+            maxColor[c] = block[maxPixel * BYTES_PER_PIXEL_RGBA + c];
+            minColor[c] = block[minPixel * BYTES_PER_PIXEL_RGBA + c];
+        }
+
+        uint16_t color0 = packRgb565(maxColor);
+        uint16_t color1 = packRgb565(minColor);
+        // color0 <= color1 would switch the block into 3 colour + transparent mode
+        if (color0 < color1) {
+            std::swap(color0, color1);
+        }
+
+        dst[0] = color0 & 0xff;
+        dst[1] = color0 >> 8;
+        dst[2] = color1 & 0xff;
+        dst[3] = color1 >> 8;
+        if (color0 == color1) {
+            return;
+        }
+
+        int palette[4][3];
+        unpackRgb565(color0, palette[0]);
+        unpackRgb565(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        uint32_t bits = 0;
+        for (int p = 0; p < BLOCK_PIXELS; p++) {
+            const uint8_t *pixel = block + p * BYTES_PER_PIXEL_RGBA;
+            int best = 0;
+            int bestError = INT32_MAX;
+            for (int i = 0; i < 4; i++) {
+                int r = pixel[0] - palette[i][0];
+                int g = pixel[1] - palette[i][1];
+                int b = pixel[2] - palette[i][2];
+                int error = r * r + g * g + b * b;
+                if (error < bestError) {
+                    bestError = error;
+                    best = i;
+                }
+            }
+            bits |= static_cast<uint32_t>(best) << (p * 2);
+        }
+
+        for (int i = 0; i < 4; i++) {
+            dst[4 + i] = static_cast<uint8_t>(bits >> (i * 8));
+        }
+    }
+
+    // Both BC formats store 16 byte blocks row by row, only the block encoder differs
+    template<typename Encoder>
+    static void compressBlocks(const GlyphView &glyphs, glyphFormat_e format, size_t bytesPerPixel, uint8_t *dst, Encoder encoder)
+    {
+        const unsigned int width = glyphs.getWidth();
+        const unsigned int height = glyphs.getHeight();
+        const unsigned int blocksX = GlyphView::getStorageSize(format, width) / COMPRESSED_BLOCK_SIZE;
+        const unsigned int blocksY = GlyphView::getStorageSize(format, height) / COMPRESSED_BLOCK_SIZE;
+
+        uint8_t block[BLOCK_PIXELS * BYTES_PER_PIXEL_RGBA];
+        for (unsigned int i = 0; i < glyphs.getCount(); i++) {
+            const uint8_t *glyph = glyphs.getGlyph(i);
+            for (unsigned int by = 0; by < blocksY; by++) {
+                for (unsigned int bx = 0; bx < blocksX; bx++) {
+                    fetchBlock(glyph, width, height, bytesPerPixel, bx, by, block);
+                    encoder(block, dst);
+                    dst += COMPRESSED_BLOCK_BYTES;
+                }
+            }
+        }
+    }
+
+    void compressRgtc2(const GlyphView &glyphs, uint8_t *dst)
+    {
+        compressBlocks(glyphs, GLYPH_FORMAT_RGTC2, BYTES_PER_PIXEL_LA, dst, [](const uint8_t *block, uint8_t *target) {
+            encodeBc4Block(block, BYTES_PER_PIXEL_LA, 0, target);
+            encodeBc4Block(block, BYTES_PER_PIXEL_LA, 1, target + 8);
+        });
+    }
+
+    glyphFormat_e selectFormat(const GlyphView &glyphs, textureCompression_e compression)
+    {
+        if (compression == TEXTURE_COMPRESSION_NONE) {
+            return GLYPH_FORMAT_RGBA8;
+        }
+
+        if (compression == TEXTURE_COMPRESSION_SDF) {
+            return GLYPH_FORMAT_SDF;
+        }
+
+        if (isGrayscale(glyphs)) {
+            return compression == TEXTURE_COMPRESSION_BLOCK ? GLYPH_FORMAT_RGTC2 : GLYPH_FORMAT_LA8;
+        }
+        return compression == TEXTURE_COMPRESSION_BLOCK ? GLYPH_FORMAT_BC3 : GLYPH_FORMAT_RGBA8;
+    }
+
+    void compressBc3(const GlyphView &glyphs, uint8_t *dst)
+    {
+        compressBlocks(glyphs, GLYPH_FORMAT_BC3, BYTES_PER_PIXEL_RGBA, dst, [](const uint8_t *block, uint8_t *target) {
+            encodeBc4Block(block, BYTES_PER_PIXEL_RGBA, 3, target);
+            encodeBc1Block(block, target + 8);
+        });
+    }
+
+    // 1D squared euclidean distance transform (Felzenszwalb & Huttenlocher), f is the 
+    // feature cost per sample (0 on features, a large value elsewhere)
+    static void distanceTransform1d(const double *f, double *d, int *v, double *z, int n)
+    {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -SDF_INFINITY;
+        z[1] = SDF_INFINITY;
+        for (int q = 1; q < n; q++) {
+            double s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            while (s <= z[k]) {
+                k--;
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = SDF_INFINITY;
+        }
+
+        k = 0;
+        for (int q = 0; q < n; q++) {
+            while (z[k + 1] < q) {
+                k++;
+            }
+            d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    }
+
+    // Squared distance of every pixel to the nearest pixel with a feature set, in place
+    static void distanceTransform2d(std::vector<double> &grid, int width, int height)
+    {
+        int size = std::max(width, height);
+        std::vector<double> f(size);
+        std::vector<double> d(size);
+        std::vector<int> v(size);
+        std::vector<double> z(size + 1);
+
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) {
+                f[y] = grid[y * width + x];
+            }
+            distanceTransform1d(f.data(), d.data(), v.data(), z.data(), height);
+            for (int y = 0; y < height; y++) {
+                grid[y * width + x] = d[y];
+            }
+        }
+
+        for (int y = 0; y < height; y++) {
+            distanceTransform1d(&grid[y * width], d.data(), v.data(), z.data(), width);
+            std::copy_n(d.data(), width, &grid[y * width]);
+        }
+    }
+
+    // Writes the distance field of mask into every second byte of dst, 128 is the edge, larger is inside
+    static void encodeDistanceField(const std::vector<bool> &mask, int width, int height, uint8_t *dst)
+    {
+        std::vector<double> outside(mask.size());
+        std::vector<double> inside(mask.size());
+        for (size_t i = 0; i < mask.size(); i++) {
+            outside[i] = mask[i] ? 0.0 : SDF_INFINITY;
+            inside[i] = mask[i] ? SDF_INFINITY : 0.0;
+        }
+        distanceTransform2d(outside, width, height);
+        distanceTransform2d(inside, width, height);
+
+        for (size_t i = 0; i < mask.size(); i++) {
+            // Pixel centres are half a pixel away from the edge between them
+            double distance = mask[i] ? std::sqrt(inside[i]) - 0.5 : 0.5 - std::sqrt(outside[i]);
+            double value = 128.0 + distance * 127.0 / SDF_SPREAD;
+            dst[i * BYTES_PER_PIXEL_LA] = static_cast<uint8_t>(std::clamp(value, 0.0, 255.0));
+        }
+    }
+
+    void toDistanceField(const GlyphView &glyphs, uint8_t *dst)
+    {
+        const int width = glyphs.getWidth();
+        const int height = glyphs.getHeight();
+        const size_t pixels = static_cast<size_t>(width) * height;
+
+        WorkerPool::instance()->parallelFor(glyphs.getCount(), [&](unsigned int i) {
+            const uint8_t *glyph = glyphs.getGlyph(i);
+            uint8_t *target = dst + i * pixels * BYTES_PER_PIXEL_LA;
+
+            // Channel 0 is the glyph's shape, channel 1 its bright part (the fill inside the dark outline)
+            std::vector<bool> shape(pixels);
+            std::vector<bool> fill(pixels);
+            for (size_t p = 0; p < pixels; p++) {
+                const uint8_t *pixel = glyph + p * BYTES_PER_PIXEL_RGBA;
+                int luminance = (pixel[0] * 77 + pixel[1] * 150 + pixel[2] * 29) >> 8;
+                shape[p] = pixel[3] >= 128;
+                fill[p] = shape[p] && luminance >= 128;
+            }
+
+            encodeDistanceField(shape, width, height, target);
+            encodeDistanceField(fill, width, height, target + 1);
+        });
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#include "glyphView.h"
+
+typedef enum {
+    TEXTURE_COMPRESSION_NONE = 0,       // RGBA8
+    TEXTURE_COMPRESSION_COMPACT = 1,    // Lossless LA8 for monochrome fonts, others stay RGBA8
+    TEXTURE_COMPRESSION_BLOCK = 2,      // RGTC2 for monochrome fonts, BC3 for coloured ones
+    TEXTURE_COMPRESSION_SDF = 3,        // Distance fields, sharp at any scale but monochrome
+} textureCompression_e;
+
+// Distance in pixels covered by the 0..255 range of a distance field
+#define SDF_SPREAD 4.0
+
+// CPU side conversions of RGBA8 glyphs into the compact texture formats. All 
+// destinations must hold glyphs.getCount() layers of the target format.
+namespace GlyphConvert {
+    // True if every visible pixel is grey, so the font can be stored as luminance + alpha without loss
+    bool isGrayscale(const GlyphView &glyphs);
+    // RGBA8 -> LA8
+    void toLuminanceAlpha(const GlyphView &glyphs, uint8_t *dst);
+    // LA8 -> RGTC2 (BC5)
+    void compressRgtc2(const GlyphView &glyphs, uint8_t *dst);
+    // RGBA8 -> BC3 (DXT5)
+    void compressBc3(const GlyphView &glyphs, uint8_t *dst);
+    // RGBA8 -> SDF, glyphs are converted in parallel on the worker pool
+    void toDistanceField(const GlyphView &glyphs, uint8_t *dst);
+    // Target format for a font, isGrayscale() is only evaluated if it matters
+    glyphFormat_e selectFormat(const GlyphView &glyphs, textureCompression_e compression);
+}
@@ -0,0 +1,99 @@
+#include "glyphView.h"
+
+GlyphView::GlyphView(const std::vector<glyphBlock_t> &blocks, unsigned int width, unsigned int height, unsigned int count, size_t stride, glyphFormat_e format)
+{
+    this->blocks = blocks.data();
+    this->blockCount = blocks.size();
+    this->width = width;
+    this->height = height;
+    this->count = count;
+    this->stride = stride;
+    this->format = format;
+}
+
+const glyphBlock_t *GlyphView::begin() const
+{
+    return this->blocks;
+}
+
+const glyphBlock_t *GlyphView::end() const
+{
+    return this->blocks + this->blockCount;
+}
+
+const uint8_t *GlyphView::getGlyph(unsigned int index) const
+{
+    for (const glyphBlock_t &block : *this) {
+        if (index >= block.first && index < block.first + block.count) {
+            return block.data + static_cast<size_t>(index - block.first) * this->stride;
+        }
+    }
+    return nullptr;
+}
+
+unsigned int GlyphView::getWidth() const
+{
+    return this->width;
+}
+
+unsigned int GlyphView::getHeight() const
+{
+    return this->height;
+}
+
+unsigned int GlyphView::getCount() const
+{
+    return this->count;
+}
+
+size_t GlyphView::getStride() const
+{
+    return this->stride;
+}
+
+glyphFormat_e GlyphView::getFormat() const
+{
+    return this->format;
+}
+
+unsigned int GlyphView::getStorageWidth() const
+{
+    return getStorageSize(this->format, this->width);
+}
+
+unsigned int GlyphView::getStorageHeight() const
+{
+    return getStorageSize(this->format, this->height);
+}
+
+size_t GlyphView::getLayerSize(glyphFormat_e format, unsigned int width, unsigned int height)
+{
+    switch (format) {
+        case GLYPH_FORMAT_LA8:
+        case GLYPH_FORMAT_SDF:
+            return static_cast<size_t>(width) * height * BYTES_PER_PIXEL_LA;
+        case GLYPH_FORMAT_RGTC2:
+        case GLYPH_FORMAT_BC3:
+            return static_cast<size_t>(getStorageSize(format, width) / COMPRESSED_BLOCK_SIZE) * (getStorageSize(format, height) / COMPRESSED_BLOCK_SIZE) * COMPRESSED_BLOCK_BYTES;
+        default:
+            return static_cast<size_t>(width) * height * BYTES_PER_PIXEL_RGBA;
+    }
+}
+
+unsigned int GlyphView::getStorageSize(glyphFormat_e format, unsigned int size)
+{
+    if (isCompressed(format)) {
+        return (size + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE * COMPRESSED_BLOCK_SIZE;
+    }
+    return size;
+}
+
+bool GlyphView::isCompressed(glyphFormat_e format)
+{
+    return format == GLYPH_FORMAT_RGTC2 || format == GLYPH_FORMAT_BC3;
+}
+
+bool GlyphView::isEmpty() const
+{
+    return this->blockCount == 0 || this->count == 0;
+}
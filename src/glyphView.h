@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define BYTES_PER_PIXEL_RGBA 4
+#define BYTES_PER_PIXEL_LA 2
+#define GLYPH_SLAB_ALIGNMENT 64
+#define COMPRESSED_BLOCK_SIZE 4
+#define COMPRESSED_BLOCK_BYTES 16
+
+typedef enum {
+    GLYPH_FORMAT_RGBA8 = 0,
+    GLYPH_FORMAT_LA8 = 1,       // Luminance + alpha, tinted in the shader
+    GLYPH_FORMAT_RGTC2 = 2,     // BC5 compressed luminance + alpha, padded to 4x4 blocks
+    GLYPH_FORMAT_BC3 = 3,       // BC3 (DXT5) compressed RGBA, padded to 4x4 blocks
+    GLYPH_FORMAT_SDF = 4,       // Signed distance fields of the glyph shape and its bright fill
+} glyphFormat_e;
+
+// Run of consecutive glyphs stored back to back in memory
+typedef struct {
+    const uint8_t *data;
+    unsigned int first;
+    unsigned int count;
+} glyphBlock_t;
+
+// Non owning view of a font's glyph layers. Every block is contiguous, so it 
+// can be uploaded with a single glTexSubImage3D call. Layers are row major in the
+// view's format, in image order (top row first), the renderer maps V accordingly.
+// Compressed formats store each layer as 4x4 blocks, padded to whole blocks.
+class GlyphView {
+    private:
+        const glyphBlock_t *blocks = nullptr;
+        size_t blockCount = 0;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        unsigned int count = 0;
+        size_t stride = 0;
+        glyphFormat_e format = GLYPH_FORMAT_RGBA8;
+
+    public:
+        GlyphView() = default;
+        GlyphView(const std::vector<glyphBlock_t> &blocks, unsigned int width, unsigned int height, unsigned int count, size_t stride, glyphFormat_e format);
+
+        static size_t getLayerSize(glyphFormat_e format, unsigned int width, unsigned int height);
+        static unsigned int getStorageSize(glyphFormat_e format, unsigned int size);
+        static bool isCompressed(glyphFormat_e format);
+
+        const glyphBlock_t *begin() const;
+        const glyphBlock_t *end() const;
+        const uint8_t *getGlyph(unsigned int index) const;
+        unsigned int getWidth() const;
+        unsigned int getHeight() const;
+        unsigned int getCount() const;
+        size_t getStride() const;
+        glyphFormat_e getFormat() const;
+        unsigned int getStorageWidth() const;
+        unsigned int getStorageHeight() const;
+        bool isEmpty() const;
+};
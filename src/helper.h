@@ -12,20 +12,47 @@
 #include "XPLMPlugin.h"
 #include <string.h>
 
+#include "logger.h"
+
 using namespace std::chrono;
 
 const std::string CONFIG_FILE_NAME = "inavSitlOsd.ini";
 const std::string FONTS_DIR_NAME   = "fonts";
+const std::string FONT_CACHE_DIR_NAME = "fontcache";
 
 namespace Helper {
+    template<logLevel_e level, class... Args>
+    inline void LogLevel(Args... args) 
+    {
+        if constexpr (level >= LOG_MIN_LEVEL) {
+            std::stringstream strStream;
+            (strStream << ... << args);
+            Logger::instance()->push(level, strStream.str());
+        }
+    }
+
+    template<class... Args>
+    inline void LogDebug(Args... args) 
+    {
+        LogLevel<LOG_LEVEL_DEBUG>(args...);
+    }
+
     template<class... Args>
     inline void Log(Args... args) 
     {
-        std::stringstream strStream;
-        strStream << "INAV SITL OSD: ";
-        (strStream << ... << args);
-        strStream << std::endl;
-        XPLMDebugString(strStream.str().c_str());
+        LogLevel<LOG_LEVEL_INFO>(args...);
+    }
+
+    template<class... Args>
+    inline void LogWarning(Args... args) 
+    {
+        LogLevel<LOG_LEVEL_WARNING>(args...);
+    }
+
+    template<class... Args>
+    inline void LogError(Args... args) 
+    {
+        LogLevel<LOG_LEVEL_ERROR>(args...);
     }
 
     inline std::filesystem::path getPluginDir()
@@ -51,6 +78,11 @@ namespace Helper {
         return fontList;
     }
 
+    inline std::filesystem::path getFontCacheDir()
+    {
+        return getPluginDir().append(FONT_CACHE_DIR_NAME);
+    }
+
     inline std::filesystem::path getConfigFileName() 
     {
         char prefPath[MAX_PATH]; 
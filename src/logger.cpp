@@ -0,0 +1,210 @@
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <XPLMUtilities.h>
+
+#define LOG_PREFIX              "INAV SITL OSD: "
+#define LOG_REPEAT_WINDOW_MS    5000
+#define LOG_REPEAT_BURST        3
+#define LOG_REPEAT_MAX_ENTRIES  64
+
+static const char *LEVEL_TAGS[] = {
+    "Debug: ",
+    "",
+    "Warning: ",
+    "Error: "
+};
+
+static uint32_t nowMs()
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Logger::Logger()
+{
+    for (size_t i = 0; i < LOG_RING_SIZE; i++) {
+        this->ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    this->running = true;
+    this->worker = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger()
+{
+    this->shutdown();
+}
+
+std::shared_ptr<Logger> Logger::instance()
+{
+    static std::shared_ptr<Logger> instance = std::make_shared<Logger>();
+    return instance;
+}
+
+void Logger::push(logLevel_e level, const std::string &text)
+{
+    if (!this->running) {
+        // Worker is gone, fall back to synchronous output
+        this->write(level, text);
+        return;
+    }
+
+    size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+    LogSlot *slot;
+    while (true) {
+        slot = &this->ring[pos % LOG_RING_SIZE];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (this->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Ring is full, never block the caller
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = this->enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    size_t length = std::min(text.size(), static_cast<size_t>(LOG_MSG_MAX_LENGTH - 1));
+    memcpy(slot->text, text.data(), length);
+    slot->text[length] = '\0';
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    this->pending.fetch_add(1, std::memory_order_release);
+    this->pending.notify_one();
+}
+
+void Logger::shutdown()
+{
+    if (!this->running.exchange(false)) {
+        return;
+    }
+
+    this->pending.fetch_add(1, std::memory_order_release);
+    this->pending.notify_one();
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+    this->drain();
+    this->flushRepeats(true);
+}
+
+bool Logger::pop(logLevel_e &level, std::string &text)
+{
+    LogSlot &slot = this->ring[this->dequeuePos % LOG_RING_SIZE];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != this->dequeuePos + 1) {
+        return false;
+    }
+
+    level = slot.level;
+    text = slot.text;
+    slot.sequence.store(this->dequeuePos + LOG_RING_SIZE, std::memory_order_release);
+    this->dequeuePos++;
+    return true;
+}
+
+void Logger::drain()
+{
+    logLevel_e level;
+    std::string text;
+    int64_t count = 0;
+    // Summaries of messages that stopped repeating, they would be lost waiting for another repeat
+    this->flushRepeats(false);
+    while (this->pop(level, text)) {
+        if (!this->isRateLimited(level, text)) {
+            this->write(level, text);
+        }
+        count++;
+    }
+    this->pending.fetch_sub(count, std::memory_order_acq_rel);
+
+    uint32_t dropped = this->dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        this->write(LOG_LEVEL_WARNING, std::to_string(dropped) + " log messages dropped");
+    }
+}
+
+void Logger::run()
+{
+    while (this->running) {
+        int64_t pending = this->pending.load(std::memory_order_acquire);
+        if (pending <= 0) {
+            this->pending.wait(pending, std::memory_order_acquire);
+            continue;
+        }
+        this->drain();
+    }
+}
+
+void Logger::write(logLevel_e level, const std::string &text)
+{
+    std::string line = LOG_PREFIX;
+    line += LEVEL_TAGS[level];
+    line += text;
+    line += "\n";
+    XPLMDebugString(line.c_str());
+}
+
+void Logger::writeSuppressed(const std::string &text, const RepeatState &state)
+{
+    if (state.suppressed > 0) {
+        this->write(state.level, text + " (" + std::to_string(state.suppressed) + " repeats suppressed)");
+    }
+}
+
+void Logger::flushRepeats(bool all)
+{
+    uint32_t now = nowMs();
+    std::erase_if(this->repeats, [this, now, all](const auto &entry) {
+        if (!all && now - entry.second.windowStart <= LOG_REPEAT_WINDOW_MS) {
+            return false;
+        }
+        this->writeSuppressed(entry.first, entry.second);
+        return true;
+    });
+}
+
+bool Logger::isRateLimited(logLevel_e level, const std::string &text)
+{
+    uint32_t now = nowMs();
+
+    std::unordered_map<std::string, RepeatState>::iterator it = this->repeats.find(text);
+    if (it == this->repeats.end()) {
+        // Hard cap, a flood of distinct messages is written as is rather than growing the map
+        if (this->repeats.size() >= LOG_REPEAT_MAX_ENTRIES) {
+            this->flushRepeats(false);
+            if (this->repeats.size() >= LOG_REPEAT_MAX_ENTRIES) {
+                return false;
+            }
+        }
+        RepeatState state;
+        state.windowStart = now;
+        state.count = 1;
+        state.level = level;
+        this->repeats.emplace(text, state);
+        return false;
+    }
+
+    RepeatState &state = it->second;
+    if (now - state.windowStart > LOG_REPEAT_WINDOW_MS) {
+        this->writeSuppressed(text, state);
+        state.windowStart = now;
+        state.count = 1;
+        state.suppressed = 0;
+        return false;
+    }
+
+    if (state.count < LOG_REPEAT_BURST) {
+        state.count++;
+        return false;
+    }
+
+    state.suppressed++;
+    return true;
+}
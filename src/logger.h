@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Debug messages are compiled out of release builds, override with -DLOG_MIN_LEVEL=0
+#ifndef LOG_MIN_LEVEL
+    #ifdef NDEBUG
+        #define LOG_MIN_LEVEL 1
+    #else
+        #define LOG_MIN_LEVEL 0
+    #endif
+#endif
+
+#define LOG_RING_SIZE           256
+#define LOG_MSG_MAX_LENGTH      256
+
+typedef enum {
+    LOG_LEVEL_DEBUG     = 0,
+    LOG_LEVEL_INFO      = 1,
+    LOG_LEVEL_WARNING   = 2,
+    LOG_LEVEL_ERROR     = 3,
+} logLevel_e;
+
+// Multi producer / single consumer lock free ring (bounded queue with per slot 
+// sequence numbers), drained by a background thread that writes to Log.txt. 
+class Logger {
+    private:
+        struct LogSlot {
+            std::atomic<size_t> sequence;
+            logLevel_e level;
+            char text[LOG_MSG_MAX_LENGTH];
+        };
+
+        struct RepeatState {
+            uint32_t windowStart = 0;
+            int count = 0;
+            int suppressed = 0;
+            logLevel_e level = LOG_LEVEL_INFO;
+        };
+
+        std::array<LogSlot, LOG_RING_SIZE> ring;
+        std::atomic<size_t> enqueuePos = 0;
+        size_t dequeuePos = 0;
+        std::atomic<int64_t> pending = 0;
+        std::atomic<uint32_t> dropped = 0;
+        std::atomic<bool> running = false;
+        std::thread worker;
+        std::unordered_map<std::string, RepeatState> repeats;
+
+        bool pop(logLevel_e &level, std::string &text);
+        void drain();
+        void run();
+        void write(logLevel_e level, const std::string &text);
+        bool isRateLimited(logLevel_e level, const std::string &text);
+        void writeSuppressed(const std::string &text, const RepeatState &state);
+        void flushRepeats(bool all);
+
+    public:
+        Logger();
+        ~Logger();
+
+        static std::shared_ptr<Logger> instance();
+        Logger(Logger const&) = delete;
+        Logger& operator =(Logger const&) = delete;
+
+        void push(logLevel_e level, const std::string &text);
+        void shutdown();
+};
@@ -1,5 +1,7 @@
 #include "platform.h"
 #include "osdPlugin.h"
+#include "logger.h"
+#include "workerPool.h"
 
 PLUGIN_API int XPluginStart(char *outName, char *outSig, char *outDesc)
 {
@@ -9,6 +11,8 @@ PLUGIN_API int XPluginStart(char *outName, char *outSig, char *outDesc)
 PLUGIN_API void	XPluginStop(void)
 {
     OsdPlugin::instance().reset();
+    WorkerPool::instance()->shutdown();
+    Logger::instance()->shutdown();
 }
 
 PLUGIN_API int XPluginEnable(void)
@@ -0,0 +1,115 @@
+#include "mappedFile.h"
+
+#if defined(LINUX) || defined(APPLE)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    this->close();
+}
+
+#if defined(WIN32)
+bool MappedFile::open(std::filesystem::path path)
+{
+    this->close();
+
+    this->file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (this->file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(this->file, &fileSize) || fileSize.QuadPart == 0) {
+        this->close();
+        return false;
+    }
+
+    this->fileMapping = CreateFileMappingW(this->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (this->fileMapping == NULL) {
+        this->close();
+        return false;
+    }
+
+    this->mapping = static_cast<const uint8_t*>(MapViewOfFile(this->fileMapping, FILE_MAP_READ, 0, 0, 0));
+    if (this->mapping == nullptr) {
+        this->close();
+        return false;
+    }
+
+    this->size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (this->mapping != nullptr) {
+        UnmapViewOfFile(this->mapping);
+        this->mapping = nullptr;
+    }
+
+    if (this->fileMapping != NULL) {
+        CloseHandle(this->fileMapping);
+        this->fileMapping = NULL;
+    }
+
+    if (this->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(this->file);
+        this->file = INVALID_HANDLE_VALUE;
+    }
+    this->size = 0;
+}
+#else
+bool MappedFile::open(std::filesystem::path path)
+{
+    this->close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) < 0 || fileStat.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    this->mapping = static_cast<const uint8_t*>(mapping);
+    this->size = static_cast<size_t>(fileStat.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (this->mapping != nullptr) {
+        munmap(const_cast<uint8_t*>(this->mapping), this->size);
+        this->mapping = nullptr;
+    }
+    this->size = 0;
+}
+#endif
+
+bool MappedFile::isOpen()
+{
+    return this->mapping != nullptr;
+}
+
+const uint8_t *MappedFile::getData()
+{
+    return this->mapping;
+}
+
+size_t MappedFile::getSize()
+{
+    return this->size;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "platform.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Read only memory mapping of a whole file
+class MappedFile {
+    private:
+        const uint8_t *mapping = nullptr;
+        size_t size = 0;
+#if defined(WIN32)
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE fileMapping = NULL;
+#endif
+
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator =(MappedFile const&) = delete;
+
+        bool open(std::filesystem::path path);
+        void close();
+        bool isOpen();
+        const uint8_t *getData();
+        size_t getSize();
+};
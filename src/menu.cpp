@@ -17,6 +17,8 @@
 #define MENU_REF_FONT               MAKE_MENU_REF(0x13)
 #define MENU_ITEM_REF_CONNECT       MAKE_MENU_REF(0x01)
 #define MENU_ITEM_REF_IP_ADDRESS    MAKE_MENU_REF(0x02)
+#define MENU_ITEM_REF_RELOAD_PLACEMENT MAKE_MENU_REF(0x03)
+#define MENU_ITEM_REF_SHOW_WINDOW   MAKE_MENU_REF(0x04)
 
 Menu::Menu()
 {
@@ -50,6 +52,9 @@ Menu::Menu()
 
     this->fontMenuWtfOsIdx = XPLMAppendMenuItem(this->fontMenuId, "WTF OS", 0, 0);
     this->fontMenuWtfOsId = XPLMCreateMenu("WTF OS", this->fontMenuId, this->fontMenuWtfOsIdx, &this->staticMenuHandler, MENU_REF_FONT);
+
+    this->reloadPlacementIdx = XPLMAppendMenuItem(this->menuId, "Reload OSD placement", MENU_ITEM_REF_RELOAD_PLACEMENT, 0);
+    this->showWindowIdx = XPLMAppendMenuItem(this->menuId, "Show OSD window", MENU_ITEM_REF_SHOW_WINDOW, 0);
 }
 
 Menu::~Menu()
@@ -193,6 +198,26 @@ void Menu::registerOnFontChangedCb(std::function<void(std::string)> callback)
     }
 }
 
+void Menu::registerOnReloadPlacementCb(std::function<void(void)> callback)
+{
+    if (callback) {
+        this->onReloadPlacement = callback;
+    }
+}
+
+void Menu::registerOnShowWindowCb(std::function<void(void)> callback)
+{
+    if (callback) {
+        this->onShowWindow = callback;
+    }
+}
+
+void Menu::setWindowState(bool available, bool visible)
+{
+    XPLMEnableMenuItem(this->menuId, this->showWindowIdx, available);
+    XPLMCheckMenuItem(this->menuId, this->showWindowIdx, visible ? xplm_Menu_Checked : xplm_Menu_Unchecked);
+}
+
 void Menu::menuHandler(void *in_menu_ref, void *in_item)
 {
     if (IS_MENU_REF(in_menu_ref, MENU_REF_PORTS)) {
@@ -204,6 +229,10 @@ void Menu::menuHandler(void *in_menu_ref, void *in_item)
             this->onConnect();
         } else if (IS_MENU_REF(in_item, MENU_ITEM_REF_IP_ADDRESS)) {
             IPInputWidget::instance()->show();
+        } else if (IS_MENU_REF(in_item, MENU_ITEM_REF_RELOAD_PLACEMENT)) {
+            this->onReloadPlacement();
+        } else if (IS_MENU_REF(in_item, MENU_ITEM_REF_SHOW_WINDOW)) {
+            this->onShowWindow();
         }
     } else if (IS_MENU_REF(in_menu_ref, MENU_REF_FONT)) {
         size_t idx = (size_t)in_item;
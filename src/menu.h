@@ -19,6 +19,8 @@ class Menu {
         std::vector<uint8_t> portIdx;
         XPLMMenuID portMenuId;
         int ipAdressMenuIdx;
+        int reloadPlacementIdx;
+        int showWindowIdx;
 
         int fontMenuIdx;
         XPLMMenuID fontMenuId;
@@ -41,6 +43,8 @@ class Menu {
         std::function<void(void)> onConnect;
         std::function<void(int)> onPortChanged;
         std::function<void(std::string)> onFontChanged;
+        std::function<void(void)> onReloadPlacement;
+        std::function<void(void)> onShowWindow;
 
         static void staticMenuHandler(void * in_menu_ref, void * in_item);       
     
@@ -62,6 +66,10 @@ class Menu {
         void registerOnConnectCb(std::function<void(void)> callback);
         void registerOnPortChangedCb(std::function<void(int)> callback);
         void registerOnFontChangedCb(std::function<void(std::string)> callback);
+        void registerOnReloadPlacementCb(std::function<void(void)> callback);
+        void registerOnShowWindowCb(std::function<void(void)> callback);
+        // Disabled without a configured OSD window
+        void setWindowState(bool available, bool visible);
         void menuHandler(void * in_menu_ref, void * in_item);
         void destroy();        
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "msp.h"
 #include "helper.h"
+#include "perfCounters.h"
 
 #define MSP_START '$'
 #define MSP_V1 'M'
@@ -28,12 +29,14 @@ bool MSP::connect(std::string ipAddress, int port)
         return false;
     }
 
+    this->receiveTime = getTickCount();
     return true;
 }
 
 void MSP::disconnect()
 {
     this->tcp->closeConnection();
+    PerfCounters::instance()->set(PERF_MSP_CONNECTED, 0);
     this->onDisconnect();
 }
 
@@ -82,7 +85,6 @@ void MSP::send(mspCommand_e cmd, std::vector<uint8_t> payload)
     buffer[buffer.size() - 1] = (uint8_t)crc;
 
     if (this->tcp->send(buffer) > 0) {
-        this->sendTime = getTickCount();
         this->waitForResponse = true;
     } else {
       this->disconnect();
@@ -91,18 +93,18 @@ void MSP::send(mspCommand_e cmd, std::vector<uint8_t> payload)
 
 void MSP::receive()
 {
-    if (getTickCount() > this->sendTime + MSP_TIMEOUT) {
-        this->sendTime = 0;
-        Log("MSP connection timed out");
-        this->disconnect();
-        return;
-    }
-
     std::vector<uint8_t> buffer = tcp->read();
     if (buffer.empty()) {
+        // A link is alive as long as anything arrives, polled responses or unsolicited DisplayPort frames
+        if (getTickCount() > this->receiveTime + MSP_TIMEOUT) {
+            LogWarning("MSP connection timed out");
+            this->disconnect();
+        }
         return;
     } 
 
+    PerfCounters::instance()->add(PERF_BYTES_RECEIVED, buffer.size());
+    this->receiveTime = getTickCount();
     this->waitForResponse = false;
     this->decode(buffer);
 }
@@ -146,6 +148,7 @@ void MSP::decode(std::vector<uint8_t> buffer)
         break;
       default:
         //unknown protocol
+        PerfCounters::instance()->add(PERF_MSP_RESYNCS);
         this->decoderState = DS_IDLE;
       }
       break;
@@ -203,6 +206,7 @@ void MSP::decode(std::vector<uint8_t> buffer)
       else
       {
         //too large payload
+        PerfCounters::instance()->add(PERF_MSP_RESYNCS);
         this->decoderState = DS_IDLE;
       }
       break;
@@ -306,10 +310,16 @@ void MSP::decode(std::vector<uint8_t> buffer)
 
 void MSP::dispatchMessage(uint8_t crc) 
 {
-  if (this->message_checksum == crc) {
-    this->onMessageReceived((mspCommand_e)this->code, this->message_buffer);
-    this->decoderState = DS_IDLE;
+  this->decoderState = DS_IDLE;
+  if (this->message_checksum != crc) {
+    PerfCounters::instance()->add(PERF_MSP_CHECKSUM_FAILURES);
+    LogDebug("MSP checksum mismatch, code: ", this->code);
+    return;
   }
+
+  PerfCounters::instance()->add(PERF_MSP_FRAMES_DECODED);
+  PerfCounters::instance()->set(PERF_MSP_CONNECTED, 1);
+  this->onMessageReceived((mspCommand_e)this->code, this->message_buffer);
 }
 
 int MSP::crc8_Dvb_S2(int crc, int ch)
@@ -39,7 +39,7 @@ typedef enum
 class MSP {
     private:
         std::unique_ptr<TCP> tcp;
-        uint32_t sendTime = 0;
+        uint32_t receiveTime = 0;
         bool waitForResponse = false;
 
         decoderState_e decoderState = DS_IDLE;
@@ -1,37 +1,69 @@
 #include "osd.h"
 
 #include "helper.h"
+#include "perfCounters.h"
+#include "workerPool.h"
+#include "fontCache.h"
 
 using namespace Helper;
 
+#include <algorithm>
 #include <filesystem>
 
 typedef enum {
+    DP_SUB_CMD_HEARTBEAT = 0,
+    DP_SUB_CMD_RELEASE = 1,
     DP_SUB_CMD_CLEAR_SCREEN = 2,
     DP_SUB_CMD_WRITE_STRING = 3,
     DP_SUB_CMD_DRAW_SCREEN = 4,
     DP_SUB_CMD_SET_OPTIONS = 5
 } mspDisplayportSubCmd_t;
 
-OSD::OSD()
+typedef enum {
+    DP_RESOLUTION_SD_3016 = 0,
+    DP_RESOLUTION_HD_5018 = 1,
+    DP_RESOLUTION_HD_3016 = 2,
+    DP_RESOLUTION_HD_6022 = 3,
+    DP_RESOLUTION_HD_5320 = 4
+} mspDisplayportResolution_t;
+
+#define TOAST_ROW 2
+#define STATS_HUD_INTERVAL 1000
+
+// Flight controllers send a heartbeat about every 500 ms while the DisplayPort is held
+#define DP_HEARTBEAT_TIMEOUT 1500
+
+OSD::OSD(renderOptions_t renderOptions, const std::vector<std::string> &fontNames)
 {
-    this->osdRenderer = std::make_unique<OsdRenderer>();
+    this->osdRenderer = std::make_unique<OsdRenderer>(renderOptions);
+    this->statsHud = renderOptions.statsHud;
+    FontCache::setCacheDir(getFontCacheDir());
     this->fontsHDZero = std::vector<std::shared_ptr<FontHDZero>>();
     this->fontsWtfOs = std::vector<std::shared_ptr<FontWtfOS>>();
     this->fontsWalksnail = std::vector<std::shared_ptr<FontWalksnail>>();
+    // Only names and metadata are read here, glyphs are decoded on first use
     for (std::filesystem::path path : getFontPaths("wtfos", true)) {
-        this->fontsWtfOs.push_back(std::make_shared<FontWtfOS>(path));
+        std::shared_ptr<FontWtfOS> font = std::make_shared<FontWtfOS>(path);
+        if (font->isValid()) {
+            this->fontsWtfOs.push_back(font);
+        }
     }
     
     for (std::filesystem::path path : getFontPaths("hdzero", false)) {
-        this->fontsHDZero.push_back(std::make_shared<FontHDZero>(path));
+        std::shared_ptr<FontHDZero> font = std::make_shared<FontHDZero>(path);
+        if (font->isValid()) {
+            this->fontsHDZero.push_back(font);
+        }
     }
 
     for (std::filesystem::path path : getFontPaths("walksnail", false)) {
-        this->fontsWalksnail.push_back(std::make_shared<FontWalksnail>(path));
+        std::shared_ptr<FontWalksnail> font = std::make_shared<FontWalksnail>(path);
+        if (font->isValid()) {
+            this->fontsWalksnail.push_back(font);
+        }
     }
 
-    this->setDefaultFonts();
+    this->setInitialFonts(fontNames);
 }
 
 OSD::~OSD()
@@ -49,28 +81,94 @@ void OSD::setVideoSystem(videoSystem_e system)
             this->actualRows = HDZERO_ROWS;
             this->actualCols = HDZERO_COLS;
             if (!this->fontsHDZero.empty()) {
-                this->osdRenderer->LoadFont(this->activeHDZeroFont);
+                this->loadFont(this->activeHDZeroFont);
             }
             break;
         case VIDEO_SYSTEM_WALKSNAIL:
             this->actualRows = WALKSNAIL_ROWS;
             this->actualCols = WALKSNAIL_COLS;
             if (!this->fontsWalksnail.empty()) {
-                this->osdRenderer->LoadFont(this->activeWalksnailFont);
+                this->loadFont(this->activeWalksnailFont);
             }
             break;
         case VIDEO_SYSTEM_WTFOS:
             this->actualRows = DJI_ROWS;
             this->actualCols = DJI_COLS;
             if (!this->fontsWtfOs.empty()) {
-                this->osdRenderer->LoadFont(this->activeWtfOsFont);
+                this->loadFont(this->activeWtfOsFont);
             }
             break;
         default:
             this->actualRows = this->actualCols = 0;
     }
+    this->osdRenderer->setActiveGrid(this->actualRows, this->actualCols);
 }
 
+void OSD::loadFont(std::shared_ptr<FontBase> font)
+{
+    // Fonts with a complete texture in the renderer's cache don't need their glyphs any more
+    if (this->osdRenderer->isFontResident(font)) {
+        this->osdRenderer->LoadFont(font);
+        this->evictUnusedFonts();
+        return;
+    }
+
+    if (!font->load()) {
+        LogError("Unable to load font: ", font->getName());
+        return;
+    }
+
+    this->osdRenderer->LoadFont(font);
+    this->evictUnusedFonts();
+}
+
+void OSD::prefetchFonts()
+{
+    // The last load to finish logs the batch, no worker waits for the others.
+    // The caller holds one count until every load is submitted.
+    std::shared_ptr<prefetchBatch_t> batch = std::make_shared<prefetchBatch_t>();
+    batch->start = steady_clock::now();
+    std::function<void()> finish = [batch]() {
+        if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && batch->count > 0) {
+            Log(batch->count, " fonts decoded in ", duration_cast<milliseconds>(steady_clock::now() - batch->start).count(), " ms");
+        }
+    };
+
+    for (std::shared_ptr<FontBase> font : std::initializer_list<std::shared_ptr<FontBase>>{this->activeHDZeroFont, this->activeWalksnailFont, this->activeWtfOsFont}) {
+        if (!font) {
+            continue;
+        }
+        batch->remaining.fetch_add(1, std::memory_order_relaxed);
+        if (font->prefetch(finish)) {
+            batch->count++;
+        } else {
+            batch->remaining.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    finish();
+}
+
+void OSD::evictUnusedFonts()
+{
+    // Fonts still streamed to the GPU are unloaded on a later call
+    for (std::shared_ptr<FontWtfOS> font : this->fontsWtfOs) {
+        if (font != this->activeWtfOsFont && !this->osdRenderer->needsFontGlyphs(font)) {
+            font->unload();
+        }
+    }
+
+    for (std::shared_ptr<FontHDZero> font : this->fontsHDZero) {
+        if (font != this->activeHDZeroFont && !this->osdRenderer->needsFontGlyphs(font)) {
+            font->unload();
+        }
+    }
+
+    for (std::shared_ptr<FontWalksnail> font : this->fontsWalksnail) {
+        if (font != this->activeWalksnailFont && !this->osdRenderer->needsFontGlyphs(font)) {
+            font->unload();
+        }
+    }
+}
 
 std::vector<std::string> OSD::getWtfFontNames()
 {
@@ -137,7 +235,7 @@ void OSD::decode(mspCommand_e cmd, std::vector<uint8_t> data)
         case MSP2_INAV_OSD_PREFERENCES:
         {    
             if ((data[0] < VIDEO_SYSTEM_HDZERO || data[0] > VIDEO_SYSTEM_WALKSNAIL)) {
-                Log("Warning: Unsuported video system detected, fallback to WtfOS.");
+                LogWarning("Unsuported video system detected, fallback to WtfOS.");
                 this->setVideoSystem(VIDEO_SYSTEM_WTFOS);
             } else {
                 this->setVideoSystem((videoSystem_e)data[0]);
@@ -148,7 +246,13 @@ void OSD::decode(mspCommand_e cmd, std::vector<uint8_t> data)
         case MSP_DISPLAYPORT:
         {
             mspDisplayportSubCmd_t subCmd = static_cast<mspDisplayportSubCmd_t>(data[0]);
-            if (subCmd == DP_SUB_CMD_CLEAR_SCREEN) {
+            if (subCmd == DP_SUB_CMD_HEARTBEAT) {
+                this->heartbeatTime = getTickCount();
+            } else if (subCmd == DP_SUB_CMD_RELEASE) {
+                // The flight controller gives up the display until it sends again
+                this->heartbeatTime = 0;
+                this->osdRenderer->clearScreen();
+            } else if (subCmd == DP_SUB_CMD_CLEAR_SCREEN) {
                 this->osdRenderer->clearScreen();
                 break;
             } else if (subCmd == DP_SUB_CMD_WRITE_STRING) {
@@ -157,10 +261,15 @@ void OSD::decode(mspCommand_e cmd, std::vector<uint8_t> data)
                 }
                 uint8_t row = data[1];
                 uint8_t col = data[2];
-                bool isExtdChar = data[3];
-                for (size_t i = 4; i < data.size(); i++) {
-                    this->osdRenderer->setCharacter(row, col + i - 4, isExtdChar ? (static_cast<uint16_t>(data[i]) | 0x100) : data[i]);
+                uint8_t attributes = data[3];
+                this->osdRenderer->writeRow(row, col, std::span<const uint8_t>(data).subspan(4), attributes);
+            } else if (subCmd == DP_SUB_CMD_DRAW_SCREEN) {
+                PerfCounters::instance()->add(PERF_DP_COMMITS);
+            } else if (subCmd == DP_SUB_CMD_SET_OPTIONS) {
+                if (data.size() < 3) {
+                    break;
                 }
+                this->setOptions(data[1], data[2]);
             }
             break;
         }
@@ -169,7 +278,75 @@ void OSD::decode(mspCommand_e cmd, std::vector<uint8_t> data)
     }
 }
 
-void OSD::setActiveFont(std::string name)
+void OSD::setOptions(uint8_t fontIndex, uint8_t resolution)
+{
+    videoSystem_e system;
+    std::vector<std::string> fontNames;
+    switch (resolution) {
+        case DP_RESOLUTION_HD_5018:
+            system = VIDEO_SYSTEM_HDZERO;
+            fontNames = this->getHDZeroFontNames();
+            break;
+        case DP_RESOLUTION_HD_5320:
+            system = VIDEO_SYSTEM_WALKSNAIL;
+            fontNames = this->getWalksnailFontNames();
+            break;
+        case DP_RESOLUTION_HD_6022:
+            system = VIDEO_SYSTEM_WTFOS;
+            fontNames = this->getWtfFontNames();
+            break;
+        default:
+            // Sent with every SET_OPTIONS, the options of an unknown resolution don't apply to any font
+            if (resolution != this->unsupportedResolution) {
+                LogWarning("Unsuported DisplayPort resolution ", static_cast<int>(resolution), ", keeping current video system.");
+                this->unsupportedResolution = resolution;
+            }
+            return;
+    }
+
+    // Font index 0 keeps the current font, others count from the first font of the system
+    bool fontChanged = false;
+    if (fontIndex > 0) {
+        if (fontIndex <= fontNames.size()) {
+            std::shared_ptr<FontBase> activeFont = this->getActiveFont(system);
+            fontChanged = !activeFont || activeFont->getName() != fontNames[fontIndex - 1];
+            if (fontChanged) {
+                this->setActiveFont(fontNames[fontIndex - 1]);
+            }
+        } else {
+            LogWarning("DisplayPort font index ", static_cast<int>(fontIndex), " out of range, keeping current font.");
+        }
+    }
+
+    // setActiveFont already reloaded the font if the system didn't change
+    if (system != this->videoSystem) {
+        this->setVideoSystem(system);
+        this->onVideoSystemChanged(this->videoSystem);
+    } else if (fontChanged) {
+        this->onVideoSystemChanged(this->videoSystem);
+    }
+}
+
+std::shared_ptr<FontBase> OSD::getActiveFont(videoSystem_e system)
+{
+    switch (system) {
+        case VIDEO_SYSTEM_HDZERO:
+            return this->activeHDZeroFont;
+        case VIDEO_SYSTEM_WALKSNAIL:
+            return this->activeWalksnailFont;
+        case VIDEO_SYSTEM_WTFOS:
+            return this->activeWtfOsFont;
+        default:
+            return nullptr;
+    }
+}
+
+bool OSD::hasHeartbeat()
+{
+    return this->heartbeatTime != 0 && getTickCount() < this->heartbeatTime + DP_HEARTBEAT_TIMEOUT;
+}
+
+videoSystem_e OSD::selectFont(std::string name)
 {
     videoSystem_e fontSystem = VIDEO_SYSTEM_NONE;
     for (std::shared_ptr<FontWtfOS> font : this->fontsWtfOs) {
@@ -193,11 +370,19 @@ void OSD::setActiveFont(std::string name)
         }    
     }
 
+    return fontSystem;
+}
+
+void OSD::setActiveFont(std::string name)
+{
+    videoSystem_e fontSystem = this->selectFont(name);
+    this->prefetchFonts();
     if (fontSystem == this->videoSystem) {
         this->setVideoSystem(fontSystem);
     } 
 }
-void OSD::setDefaultFonts()
+
+void OSD::setInitialFonts(const std::vector<std::string> &fontNames)
 {
     if (!this->fontsHDZero.empty()) {
         this->activeHDZeroFont = this->fontsHDZero[0];
@@ -209,6 +394,17 @@ void OSD::setDefaultFonts()
 
     if (!this->fontsWtfOs.empty()) {
         this->activeWtfOsFont = this->fontsWtfOs[0];
+    }
+
+    for (const std::string &name : fontNames) {
+        if (this->selectFont(name) == VIDEO_SYSTEM_NONE) {
+            LogWarning("Configured font not found: ", name);
+        }
+    }
+
+    // Decode the configured fonts in parallel, once, setVideoSystem only waits for the one it needs
+    this->prefetchFonts();
+    if (this->activeWtfOsFont) {
         this->setVideoSystem(VIDEO_SYSTEM_WTFOS);
     }
 }
@@ -220,25 +416,57 @@ void OSD::clear()
 
 void OSD::draw()
 {
+    // Toasts and the HUD live in the overlay, the flight controller's screen is left alone
     if (this->showToast && getTickCount() > this->toastEndTime) {
-        this->osdRenderer->clearScreen();
+        this->osdRenderer->clearOverlayRow(TOAST_ROW);
         this->showToast = false;
     }
 
+    if (this->statsHud && getTickCount() > this->statsHudTime + STATS_HUD_INTERVAL) {
+        this->statsHudTime = getTickCount();
+        this->updateStatsHud();
+    }
+
     this->osdRenderer->render(this->actualRows, this->actualCols);
 }
 
+void OSD::updateStatsHud()
+{
+    if (this->actualRows <= 0) {
+        return;
+    }
+
+    std::shared_ptr<PerfCounters> counters = PerfCounters::instance();
+    std::string stats = "DC " + std::to_string(counters->get(PERF_DRAW_CALLS_PER_FRAME)) +
+        " CPU " + std::to_string(counters->get(PERF_RENDER_CPU_US)) + "US" +
+        " DP " + std::to_string(counters->get(PERF_DP_COMMITS_PER_SECOND)) + "/S";
+
+    int row = this->actualRows - 1;
+    this->osdRenderer->clearOverlayRow(row);
+    this->osdRenderer->writeOverlayRow(row, 1, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(stats.data()), stats.size()), 0);
+}
+
+void OSD::setPlacement(osdPlacement_t placement)
+{
+    this->osdRenderer->setPlacement(placement);
+}
+
+void OSD::drawWindow(int left, int top, int right, int bottom)
+{
+    this->osdRenderer->drawWindow(left, top, right, bottom);
+}
+
+void OSD::setWindowVisible(bool visible)
+{
+    this->osdRenderer->setWindowVisible(visible);
+}
+
 void OSD::makeToast(std::string msg, int durationMs)
 {
-    this->showToast = true;;
+    this->showToast = true;
     this->toastEndTime = getTickCount() + durationMs;
-    this->osdRenderer->clearScreen();
-    int startCol = this->actualCols / 2 - msg.length() / 2;
-    int len = msg.length();
-    if (startCol + msg.length() >= this->actualCols) {
-        len = this->actualCols - startCol;
-    }
-    for (int i = 0; i < len; i++) {
-        this->osdRenderer->setCharacter(2, startCol + i, static_cast<uint16_t>(msg[i]));
-    }
+    // Clipped to the grid by the overlay
+    int startCol = std::max<int>(0, this->actualCols / 2 - static_cast<int>(msg.length()) / 2);
+    this->osdRenderer->clearOverlayRow(TOAST_ROW);
+    this->osdRenderer->writeOverlayRow(TOAST_ROW, startCol, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(msg.data()), msg.size()), 0);
 }
@@ -2,6 +2,8 @@
 
 #include "platform.h"
 
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <string>
 #include "msp.h"
@@ -24,6 +26,12 @@ typedef enum {
     VIDEO_SYSTEM_NONE       = 6,
 } videoSystem_e;
 
+typedef struct {
+    std::atomic<unsigned int> remaining = 1;
+    unsigned int count = 0;
+    std::chrono::steady_clock::time_point start;
+} prefetchBatch_t;
+
 class OSD {
     
     private:    
@@ -45,12 +53,26 @@ class OSD {
         int actualCols = 0;
 
         uint32_t toastEndTime = 0;
+        uint32_t heartbeatTime = 0;
+        bool statsHud = false;
+        uint32_t statsHudTime = 0;
         bool showToast = false;
+        // Last one logged, -1 for none
+        int unsupportedResolution = -1;
 
         void setVideoSystem(videoSystem_e system);
+        void loadFont(std::shared_ptr<FontBase> font);
+        void evictUnusedFonts();
+        void prefetchFonts();
+        videoSystem_e selectFont(std::string name);
+        void setInitialFonts(const std::vector<std::string> &fontNames);
+        void setOptions(uint8_t fontIndex, uint8_t resolution);
+        void updateStatsHud();
+        std::shared_ptr<FontBase> getActiveFont(videoSystem_e system);
     
     public:
-        OSD();
+        // fontNames are the configured fonts of any system, the first font of a system is used otherwise
+        OSD(renderOptions_t renderOptions, const std::vector<std::string> &fontNames);
         ~OSD();
 
         std::vector<std::string> getWtfFontNames();
@@ -65,9 +87,13 @@ class OSD {
         std::string getActiveHDZeroFontName();
         void decode(mspCommand_e cmd, std::vector<uint8_t> data);
         void setActiveFont(std::string name);
-        void setDefaultFonts();
+        // True while DisplayPort heartbeats arrive, the link is alive even if the OSD content is idle
+        bool hasHeartbeat();
         void clear();
         void draw();
         void makeToast(std::string msg, int durationMs);
+        void setPlacement(osdPlacement_t placement);
+        void drawWindow(int left, int top, int right, int bottom);
+        void setWindowVisible(bool visible);
 
 };
\ No newline at end of file
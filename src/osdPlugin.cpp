@@ -1,20 +1,76 @@
 
 #include <string.h>
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <filesystem>
+#include <limits>
 
 #include "osdPlugin.h"
 #include "helper.h"
+#include "perfCounters.h"
 
 using namespace Helper;
 using namespace std::placeholders;
 using namespace std::filesystem;
 
+// Numbers from the ini, an exception must not reach X-Plane through a plugin callback. 
+// Malformed values keep the fallback, out of range ones are clamped.
+static int readInt(mINI::INIStructure &ini, const std::string &key, int fallback, int min, int max)
+{
+    if (!ini[INI_CONFIG].has(key)) {
+        return fallback;
+    }
+
+    std::string value = ini[INI_CONFIG][key];
+    int result;
+    try {
+        result = std::stoi(value);
+    } catch (const std::exception&) {
+        LogWarning("Invalid value for ", key, ": ", value, ", using ", fallback);
+        return fallback;
+    }
+
+    if (result < min || result > max) {
+        result = std::clamp(result, min, max);
+        LogWarning("Value for ", key, " out of range: ", value, ", using ", result);
+    }
+    return result;
+}
+
+static float readFloat(mINI::INIStructure &ini, const std::string &key, float fallback, float min, float max)
+{
+    if (!ini[INI_CONFIG].has(key)) {
+        return fallback;
+    }
+
+    std::string value = ini[INI_CONFIG][key];
+    float result;
+    try {
+        result = std::stof(value);
+    } catch (const std::exception&) {
+        result = NAN;
+    }
+    if (!std::isfinite(result)) {
+        LogWarning("Invalid value for ", key, ": ", value, ", using ", fallback);
+        return fallback;
+    }
+
+    if (result < min || result > max) {
+        result = std::clamp(result, min, max);
+        LogWarning("Value for ", key, " out of range: ", value, ", using ", result);
+    }
+    return result;
+}
+
 OsdPlugin::OsdPlugin()
 {
     XPLMRegisterDrawCallback(&staticDrawCallback, xplm_Phase_Window, 0, NULL);
     this->msp = std::make_unique<MSP>();
-    this->osd = std::make_unique<OSD>();
+    // Render options have to be known before the OSD starts loading fonts
+    this->readConfig();
+    this->osd = std::make_unique<OSD>(this->renderOptions, this->getConfiguredFonts());
+    this->perfDataRefs = std::make_unique<PerfDataRefs>();
 }
 
 OsdPlugin::~OsdPlugin()
@@ -56,28 +112,39 @@ int OsdPlugin::enable()
     this->flLoopId = XPLMCreateFlightLoop(&params);
     XPLMScheduleFlightLoop(this->flLoopId, -1, true);
 
+    this->perfDataRefs->registerDataRefs();
+
     ipInputWidget->create(300, 100, 300, 105, "IP Address", "IP Address");
     ipInputWidget->registerValueChangedCb(std::bind(&OsdPlugin::ipAddressChanged, this, _1));
 
     menu->registerOnConnectCb(std::bind(&OsdPlugin::connect, this));
     menu->registerOnPortChangedCb(std::bind(&OsdPlugin::portChanged, this, _1));
     menu->registerOnFontChangedCb(std::bind(&OsdPlugin::fontChanged, this, _1));
+    menu->registerOnReloadPlacementCb(std::bind(&OsdPlugin::loadPlacement, this));
+    menu->registerOnShowWindowCb(std::bind(&OsdPlugin::toggleOsdWindow, this));
     msp->registerMessageReceivedCb(std::bind(&OsdPlugin::mspMessageReveiced, this, _1, _2));
     msp->registerDisconnectCb(std::bind(&OsdPlugin::disconnect, this));
     osd->registerOnVideoSysteChangedCb(std::bind(&OsdPlugin::videoSystemChanged, this, _1));
 
     this->loadConfig();
+    // Read again on every enable and from the menu, so placement can be tuned without restarting X-Plane or reloading fonts
+    this->loadPlacement();
     menu->setPort(this->port);
     menu->setIpAddress(this->ipAddress);
     menu->setActiveFonts(osd->getActiveHDZeroFontName(), osd->getActiveWalksnailFontName(), osd->getActiveWfosFontName());
+    this->createOsdWindow();
+    menu->setWindowState(this->osdWindow != nullptr, false);
+    this->updateOsdWindowState();
     
     return 1;
 }
 
 void OsdPlugin::disable()
 {
+    this->destroyOsdWindow();
     menu->destroy();
     XPLMDestroyFlightLoop(this->flLoopId);
+    this->perfDataRefs->unregisterDataRefs();
 }
 
 void OsdPlugin::xPluginReceiveMessage(XPLMPluginID inFrom, int inMsg, void *inParam)
@@ -89,20 +156,101 @@ void OsdPlugin::xPluginReceiveMessage(XPLMPluginID inFrom, int inMsg, void *inPa
 
 float OsdPlugin::flightLoopCb(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void *inRefcon)
 {
+    PerfCounters::instance()->updateRates(getTickCount());
     if (msp->isConnected() && getTickCount() > this->timeSinceLastLoop + LOOP_TIME) {
         this->timeSinceLastLoop = getTickCount();
         msp->receive();
+        // The flight controller only keeps its DisplayPort output, heartbeats included, running while it is polled
         msp->send(MSP_FC_VARIANT);
     }
+    PerfCounters::instance()->set(PERF_DP_HEARTBEAT, msp->isConnected() && osd->hasHeartbeat());
     return -1;
 }
 
 int OsdPlugin::drawCallback(XPLMDrawingPhase inPhase, int inIsBefore, void *inRefcon)
 {
+    steady_clock::time_point start = steady_clock::now();
+    // The window's close button only hides it
+    this->updateOsdWindowState();
     this->osd->draw();
+    PerfCounters::instance()->set(PERF_RENDER_CPU_US, duration_cast<microseconds>(steady_clock::now() - start).count());
     return 1;
 }
 
+void OsdPlugin::drawWindowCallback(XPLMWindowID inWindowID)
+{
+    int left, top, right, bottom;
+    XPLMGetWindowGeometry(inWindowID, &left, &top, &right, &bottom);
+    this->osd->drawWindow(left, top, right, bottom);
+}
+
+void OsdPlugin::createOsdWindow()
+{
+    if (this->renderOptions.windowMode == OSD_WINDOW_NONE || this->osdWindow) {
+        return;
+    }
+
+    int left, top, right, bottom;
+    XPLMGetScreenBoundsGlobal(&left, &top, &right, &bottom);
+
+    XPLMCreateWindow_t params;
+    params.structSize = sizeof(XPLMCreateWindow_t);
+    params.left = left + 50;
+    params.top = top - 150;
+    params.right = params.left + OSD_WINDOW_WIDTH;
+    params.bottom = params.top - OSD_WINDOW_HEIGHT;
+    params.visible = 1;
+    params.drawWindowFunc = &staticDrawWindowCb;
+    params.handleMouseClickFunc = &staticWindowMouseCb;
+    params.handleRightClickFunc = &staticWindowMouseCb;
+    params.handleKeyFunc = &staticWindowKeyCb;
+    params.handleCursorFunc = &staticWindowCursorCb;
+    params.handleMouseWheelFunc = &staticWindowWheelCb;
+    params.refcon = NULL;
+    params.decorateAsFloatingWindow = xplm_WindowDecorationRoundRectangle;
+    params.layer = xplm_WindowLayerFloatingWindows;
+    this->osdWindow = XPLMCreateWindowEx(&params);
+    if (!this->osdWindow) {
+        LogError("Unable to create OSD window");
+        return;
+    }
+
+    if (this->renderOptions.windowMode == OSD_WINDOW_POPOUT) {
+        XPLMSetWindowPositioningMode(this->osdWindow, xplm_WindowPopOut, -1);
+    }
+    XPLMSetWindowTitle(this->osdWindow, PLUGIN_NAME.c_str());
+    XPLMSetWindowResizingLimits(this->osdWindow, OSD_WINDOW_WIDTH / 4, OSD_WINDOW_HEIGHT / 4, OSD_WINDOW_WIDTH * 8, OSD_WINDOW_HEIGHT * 8);
+}
+
+void OsdPlugin::destroyOsdWindow()
+{
+    if (this->osdWindow) {
+        XPLMDestroyWindow(this->osdWindow);
+        this->osdWindow = nullptr;
+    }
+    this->updateOsdWindowState();
+}
+
+void OsdPlugin::toggleOsdWindow()
+{
+    if (this->osdWindow) {
+        XPLMSetWindowIsVisible(this->osdWindow, !XPLMGetWindowIsVisible(this->osdWindow));
+        this->updateOsdWindowState();
+    }
+}
+
+void OsdPlugin::updateOsdWindowState()
+{
+    bool visible = this->osdWindow && XPLMGetWindowIsVisible(this->osdWindow);
+    if (visible != this->osdWindowVisible) {
+        this->osdWindowVisible = visible;
+        this->osd->setWindowVisible(visible);
+        if (this->menu) {
+            this->menu->setWindowState(this->osdWindow != nullptr, visible);
+        }
+    }
+}
+
 void OsdPlugin::mspMessageReveiced(mspCommand_e cmd, std::vector<uint8_t> buffer)
 {
     osd->decode(cmd, buffer);
@@ -155,36 +303,151 @@ void OsdPlugin::ipAddressChanged(std::string ipAddress)
 void OsdPlugin::videoSystemChanged(videoSystem_e videoSystem)
 {
     this->menu->enbaleMenu(videoSystem, false);
+    // DisplayPort options can switch fonts as well
+    menu->setActiveFonts(osd->getActiveHDZeroFontName(), osd->getActiveWalksnailFontName(), osd->getActiveWfosFontName());
 }
 
-void OsdPlugin::loadConfig()
+void OsdPlugin::readConfig()
 {
     path path = getConfigFileName();
     mINI::INIFile config(path.generic_string());
-    if (config.read(this->ini)) {
+    if (!config.read(this->ini)) {
+        LogWarning("Unable to read config, using default values.");
+        return;
+    }
 
-        if (this->ini[INI_CONFIG].has(INI_PORT)) {
-            this->port = std::stoi(this->ini[INI_CONFIG][INI_PORT]);
+    if (this->ini[INI_CONFIG].has(INI_TEXTURE_COMPRESSION)) {
+        std::string compression = this->ini[INI_CONFIG][INI_TEXTURE_COMPRESSION];
+        if (compression == "compact") {
+            FontBase::setTextureCompression(TEXTURE_COMPRESSION_COMPACT);
+        } else if (compression == "block") {
+            FontBase::setTextureCompression(TEXTURE_COMPRESSION_BLOCK);
+        } else if (compression == "sdf") {
+            FontBase::setTextureCompression(TEXTURE_COMPRESSION_SDF);
+        } else if (compression != "none") {
+            LogWarning("Unknown texture compression: ", compression, ", using none");
         }
+    }
+
+    if (this->ini[INI_CONFIG].has(INI_TEXTURE_FILTER)) {
+        std::string filter = this->ini[INI_CONFIG][INI_TEXTURE_FILTER];
+        if (filter == "nearest") {
+            this->renderOptions.textureFilter = TEXTURE_FILTER_NEAREST;
+        } else if (filter == "trilinear") {
+            this->renderOptions.textureFilter = TEXTURE_FILTER_TRILINEAR;
+        } else if (filter != "linear") {
+            LogWarning("Unknown texture filter: ", filter, ", using linear");
+        }
+    }
+
+    if (this->ini[INI_CONFIG].has(INI_RENDER_MODE)) {
+        std::string mode = this->ini[INI_CONFIG][INI_RENDER_MODE];
+        if (mode == "grid") {
+            this->renderOptions.renderMode = RENDER_MODE_GRID;
+        } else if (mode != "instanced") {
+            LogWarning("Unknown render mode: ", mode, ", using instanced");
+        }
+    }
+
+    this->renderOptions.statsHud = readInt(this->ini, INI_STATS_HUD, this->renderOptions.statsHud, 0, 1) != 0;
+
+    if (this->ini[INI_CONFIG].has(INI_OSD_WINDOW)) {
+        std::string window = this->ini[INI_CONFIG][INI_OSD_WINDOW];
+        if (window == "floating") {
+            this->renderOptions.windowMode = OSD_WINDOW_FLOATING;
+        } else if (window == "popout") {
+            this->renderOptions.windowMode = OSD_WINDOW_POPOUT;
+        } else if (window != "none") {
+            LogWarning("Unknown OSD window: ", window, ", using none");
+        }
+    }
+
+    // Without a window the main view is the only one
+    if (this->renderOptions.windowMode != OSD_WINDOW_NONE) {
+        this->renderOptions.mainView = readInt(this->ini, INI_OSD_MAIN_VIEW, this->renderOptions.mainView, 0, 1) != 0;
+    }
+
+    // Glyph indices are 16 bit, more slots than glyphs would never be used
+    this->renderOptions.glyphCacheSlots = readInt(this->ini, INI_GLYPH_CACHE_SLOTS, this->renderOptions.glyphCacheSlots, 0, 65536);
+
+    const int textureCacheMb = readInt(this->ini, INI_TEXTURE_CACHE_MB, this->renderOptions.textureCacheBudget / (1024 * 1024), 0, 4096);
+    this->renderOptions.textureCacheBudget = static_cast<size_t>(textureCacheMb) * 1024 * 1024;
+}
+
+void OsdPlugin::loadConfig()
+{
+    if (this->ini.has(INI_CONFIG)) {
+
+        this->port = readInt(this->ini, INI_PORT, this->port, 1, 65535);
 
         if (this->ini[INI_CONFIG].has(INI_IP)) {
             this->ipAddress = this->ini[INI_CONFIG][INI_IP];
         }
+    }
+}
 
-        if (this->ini[INI_CONFIG].has(HDZERO_FONT)) {
-            osd->setActiveFont(this->ini[INI_CONFIG][HDZERO_FONT]);
+std::vector<std::string> OsdPlugin::getConfiguredFonts()
+{
+    // Applied by the OSD's constructor, so only these fonts are decoded at start
+    std::vector<std::string> fontNames;
+    for (const std::string &key : {HDZERO_FONT, WALKSNAIL_FONT, WTFOS_FONT}) {
+        if (this->ini[INI_CONFIG].has(key)) {
+            fontNames.push_back(this->ini[INI_CONFIG][key]);
         }
+    }
+    return fontNames;
+}
 
-        if (this->ini[INI_CONFIG].has(WALKSNAIL_FONT)) {
-            osd->setActiveFont(this->ini[INI_CONFIG][WALKSNAIL_FONT]);
-        }
+void OsdPlugin::loadPlacement()
+{
+    mINI::INIStructure ini;
+    mINI::INIFile config(getConfigFileName().generic_string());
+    if (!config.read(ini) || !ini.has(INI_CONFIG)) {
+        return;
+    }
 
-        if (this->ini[INI_CONFIG].has(WTFOS_FONT)) {
-            osd->setActiveFont(this->ini[INI_CONFIG][WTFOS_FONT]);
+    osdPlacement_t placement;
+    if (ini[INI_CONFIG].has(INI_OSD_ANCHOR)) {
+        static const std::vector<std::pair<std::string, osdAnchor_e>> anchors = {
+            {"center", OSD_ANCHOR_CENTER},
+            {"top_left", OSD_ANCHOR_TOP_LEFT},
+            {"top", OSD_ANCHOR_TOP},
+            {"top_right", OSD_ANCHOR_TOP_RIGHT},
+            {"left", OSD_ANCHOR_LEFT},
+            {"right", OSD_ANCHOR_RIGHT},
+            {"bottom_left", OSD_ANCHOR_BOTTOM_LEFT},
+            {"bottom", OSD_ANCHOR_BOTTOM},
+            {"bottom_right", OSD_ANCHOR_BOTTOM_RIGHT},
+        };
+        std::string anchor = ini[INI_CONFIG][INI_OSD_ANCHOR];
+        bool found = false;
+        for (const std::pair<std::string, osdAnchor_e> &entry : anchors) {
+            if (entry.first == anchor) {
+                placement.anchor = entry.second;
+                found = true;
+            }
+        }
+        if (!found) {
+            LogWarning("Unknown OSD anchor: ", anchor, ", using center");
         }
+    }
+
+    placement.offsetX = readInt(ini, INI_OSD_OFFSET_X, placement.offsetX, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+    placement.offsetY = readInt(ini, INI_OSD_OFFSET_Y, placement.offsetY, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+
+    float scale = readFloat(ini, INI_OSD_SCALE, placement.scale, std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max());
+    if (scale > 0.0f) {
+        placement.scale = scale;
     } else {
-        Log("Warning: Unable to read config, using default values.");
+        LogWarning("OSD scale must be positive: ", scale, ", using ", placement.scale);
     }
+
+    placement.opacity = readFloat(ini, INI_OSD_OPACITY, placement.opacity, 0.0f, 1.0f);
+    placement.safeArea = readFloat(ini, INI_OSD_SAFE_AREA, placement.safeArea, 0.0f, 45.0f);
+    // -1 for the whole window
+    placement.monitor = readInt(ini, INI_OSD_MONITOR, placement.monitor, -1, std::numeric_limits<int>::max());
+
+    this->osd->setPlacement(placement);
 }
 
 void OsdPlugin::saveConfig()
@@ -198,7 +461,7 @@ void OsdPlugin::saveConfig()
     path path = getConfigFileName();
     mINI::INIFile config(path.generic_string());
     if (!config.generate(this->ini, true)) {
-        Log("Warning: Unable to save config.");
+        LogWarning("Unable to save config.");
     }
 }
 
@@ -212,3 +475,28 @@ int OsdPlugin::staticDrawCallback(XPLMDrawingPhase inPhase, int inIsBefore, void
     return instance()->drawCallback(inPhase, inIsBefore, inRefcon);
 }
 
+
+void OsdPlugin::staticDrawWindowCb(XPLMWindowID inWindowID, void *inRefcon)
+{
+    instance()->drawWindowCallback(inWindowID);
+}
+
+int OsdPlugin::staticWindowMouseCb(XPLMWindowID inWindowID, int x, int y, XPLMMouseStatus inMouse, void *inRefcon)
+{
+    // Dragging and resizing are handled by X-Plane's decoration
+    return 0;
+}
+
+void OsdPlugin::staticWindowKeyCb(XPLMWindowID inWindowID, char inKey, XPLMKeyFlags inFlags, char inVirtualKey, void *inRefcon, int losingFocus)
+{
+}
+
+XPLMCursorStatus OsdPlugin::staticWindowCursorCb(XPLMWindowID inWindowID, int x, int y, void *inRefcon)
+{
+    return xplm_CursorDefault;
+}
+
+int OsdPlugin::staticWindowWheelCb(XPLMWindowID inWindowID, int x, int y, int wheel, int clicks, void *inRefcon)
+{
+    return 0;
+}
@@ -10,6 +10,7 @@
 #include "menu.h"
 #include "msp.h"
 #include "osd.h"
+#include "perfDataRefs.h"
 #include "widgets/ipInputWidget.h"
 
 const std::string NAME = "INAV SITL OSD";
@@ -25,6 +26,24 @@ const std::string INI_IP          = "ip";
 const std::string WALKSNAIL_FONT  = "walksnail_font";
 const std::string HDZERO_FONT     = "hdzero_font";
 const std::string WTFOS_FONT      = "wtfos_font";
+const std::string INI_TEXTURE_COMPRESSION = "texture_compression";
+const std::string INI_TEXTURE_FILTER = "texture_filter";
+const std::string INI_GLYPH_CACHE_SLOTS = "glyph_cache_slots";
+const std::string INI_TEXTURE_CACHE_MB = "texture_cache_mb";
+const std::string INI_RENDER_MODE = "render_mode";
+const std::string INI_STATS_HUD = "stats_hud";
+const std::string INI_OSD_ANCHOR = "osd_anchor";
+const std::string INI_OSD_OFFSET_X = "osd_offset_x";
+const std::string INI_OSD_OFFSET_Y = "osd_offset_y";
+const std::string INI_OSD_SCALE = "osd_scale";
+const std::string INI_OSD_OPACITY = "osd_opacity";
+const std::string INI_OSD_SAFE_AREA = "osd_safe_area";
+const std::string INI_OSD_MONITOR = "osd_monitor";
+const std::string INI_OSD_WINDOW = "osd_window";
+const std::string INI_OSD_MAIN_VIEW = "osd_main_view";
+
+const int OSD_WINDOW_WIDTH = 600;
+const int OSD_WINDOW_HEIGHT = 240;
 
 const uint LOOP_TIME = 125; // ms
 const std::string PLUGIN_NAME = "INAV SITL OSD PLUGIN";
@@ -38,7 +57,11 @@ class OsdPlugin {
         XPLMFlightLoopID flLoopId;
         mINI::INIStructure ini;
         std::unique_ptr<MSP> msp;
+        std::unique_ptr<PerfDataRefs> perfDataRefs;
         uint32_t timeSinceLastLoop = 0;
+        renderOptions_t renderOptions;
+        XPLMWindowID osdWindow = nullptr;
+        bool osdWindowVisible = false;
 
         int port = STANDARD_PORT;
         std::string ipAddress = STANDRD_IP;
@@ -58,6 +81,17 @@ class OsdPlugin {
         static int staticDrawCallback(XPLMDrawingPhase inPhase, int inIsBefore, void *inRefcon);
         int drawCallback(XPLMDrawingPhase inPhase, int inIsBefore, void *inRefcon);
 
+        static void staticDrawWindowCb(XPLMWindowID inWindowID, void *inRefcon);
+        static int staticWindowMouseCb(XPLMWindowID inWindowID, int x, int y, XPLMMouseStatus inMouse, void *inRefcon);
+        static void staticWindowKeyCb(XPLMWindowID inWindowID, char inKey, XPLMKeyFlags inFlags, char inVirtualKey, void *inRefcon, int losingFocus);
+        static XPLMCursorStatus staticWindowCursorCb(XPLMWindowID inWindowID, int x, int y, void *inRefcon);
+        static int staticWindowWheelCb(XPLMWindowID inWindowID, int x, int y, int wheel, int clicks, void *inRefcon);
+        void drawWindowCallback(XPLMWindowID inWindowID);
+        void createOsdWindow();
+        void destroyOsdWindow();
+        void toggleOsdWindow();
+        void updateOsdWindowState();
+
         void mspMessageReveiced(mspCommand_e cmd, std::vector<uint8_t> buffer);
         void connect();
         void disconnect();
@@ -65,7 +99,10 @@ class OsdPlugin {
         void portChanged(int port);
         void ipAddressChanged(std::string ipAddress);
         void videoSystemChanged(videoSystem_e videoSystem);
+        void readConfig();
+        std::vector<std::string> getConfiguredFonts();
         void loadConfig();
+        void loadPlacement();
         void saveConfig();
     
     public:
@@ -1,6 +1,11 @@
 #include "osdRenderer.h"
 
 #include "helper.h"
+#include "perfCounters.h"
+#include "glStateScope.h"
+
+#include <algorithm>
+#include <cstring>
 
 #include "osd.h"
 #include <glm/glm.hpp>
@@ -14,69 +19,215 @@ const char* vertexShaderSource = R"(
 #version 330 core
 layout(location = 0) in vec2 aPos;
 layout(location = 1) in vec2 aTexCoord;
+layout(location = 2) in vec2 aCellPos;
+layout(location = 3) in int aLayer;
 
 out vec2 TexCoord;
+flat out int Layer;
+
+uniform vec2 cellSize;
+uniform float time;
+uniform vec4 placement;
 
-uniform mat4 transform;
+const int LAYER_BLINK = 0x8000;
+const int LAYER_INDEX_MASK = 0x7FFF;
+const float BLINK_FREQUENCY = 2.5;
 
 void main() 
 {
-    gl_Position = transform * vec4(aPos, 0.0, 1.0);
+    // Empty cells and blinking ones in their off phase are moved outside the clip volume
+    bool blinkOff = (aLayer & LAYER_BLINK) != 0 && fract(time * BLINK_FREQUENCY) >= 0.5;
+    if (aLayer < 0 || blinkOff) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+    } else {
+        gl_Position = vec4((aCellPos + aPos * cellSize) * placement.xy + placement.zw, 0.0, 1.0);
+    }
     TexCoord = aTexCoord;
+    Layer = aLayer & LAYER_INDEX_MASK;
 } 
 )";
 
+// Shared by both render modes, prepended to their fragment shaders
+const char* glyphShaderSource = R"(
+#version 330 core
+uniform sampler2DArray textureArray;
+uniform int glyphMode;
+uniform vec4 tint;
+uniform vec2 texScale;
+
+const int GLYPH_MODE_LUMINANCE_ALPHA = 1;
+const int GLYPH_MODE_SDF = 2;
+
+vec4 shadeGlyph(vec4 texel)
+{
+    if (glyphMode == GLYPH_MODE_LUMINANCE_ALPHA) {
+        texel = vec4(texel.rrr, texel.g);
+    } else if (glyphMode == GLYPH_MODE_SDF) {
+        // The edge is at 0.5, smoothing over about one screen pixel keeps it sharp at any scale
+        float smoothing = max(fwidth(texel.r), 0.001) * 0.75;
+        float alpha = smoothstep(0.5 - smoothing, 0.5 + smoothing, texel.r);
+        float fill = smoothstep(0.5 - smoothing, 0.5 + smoothing, texel.g);
+        texel = vec4(vec3(fill), alpha);
+    }
+    return texel * tint;
+}
+)";
+
 const char* fragmentShaderSource = R"(
+out vec4 FragColor;
+in vec2 TexCoord;
+flat in int Layer;
+
+void main()
+{
+	FragColor = shadeGlyph(texture(textureArray, vec3(TexCoord * texScale, Layer)));
+}
+)";
+
+const char* gridVertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in vec2 aPos;
+
+out vec2 GridCoord;
+
+uniform vec2 gridOrigin;
+uniform vec2 gridExtent;
+uniform vec2 gridSize;
+uniform vec4 placement;
+
+void main()
+{
+    gl_Position = vec4((gridOrigin + aPos * gridExtent) * placement.xy + placement.zw, 0.0, 1.0);
+    // Column and row, fractional part is the position within the cell
+    GridCoord = vec2(aPos.x, -aPos.y) * gridSize;
+}
+)";
+
+const char* gridFragmentShaderSource = R"(
+out vec4 FragColor;
+in vec2 GridCoord;
+
+uniform usampler2D grid;
+uniform vec2 gridSize;
+uniform float time;
+
+const uint GRID_CELL_EMPTY = 0xFFFFu;
+const uint LAYER_BLINK = 0x8000u;
+const uint LAYER_INDEX_MASK = 0x7FFFu;
+const float BLINK_FREQUENCY = 2.5;
+
+void main()
+{
+    ivec2 cell = min(ivec2(GridCoord), ivec2(gridSize) - 1);
+    uint layer = texelFetch(grid, cell, 0).r;
+    bool blinkOff = (layer & LAYER_BLINK) != 0u && fract(time * BLINK_FREQUENCY) >= 0.5;
+    if (layer == GRID_CELL_EMPTY || blinkOff) {
+        discard;
+    }
+    layer &= LAYER_INDEX_MASK;
+
+    // Gradients of the continuous coordinate, the ones of fract() jump at every cell border
+    vec2 uv = fract(GridCoord) * texScale;
+    vec4 texel = textureGrad(textureArray, vec3(uv, float(layer)), dFdx(GridCoord) * texScale, dFdy(GridCoord) * texScale);
+    FragColor = shadeGlyph(texel);
+}
+)";
+
+// Copies the cached OSD texture into a window, positions are window boxels
+const char* windowVertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec2 aTexCoord;
+
+out vec2 TexCoord;
+
+uniform vec4 windowRect;
+uniform mat4 modelview;
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * modelview * vec4(windowRect.xy + aPos * windowRect.zw, 0.0, 1.0);
+    // The texture was rendered bottom up
+    TexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
+}
+)";
+
+const char* windowFragmentShaderSource = R"(
 #version 330 core
 out vec4 FragColor;
 in vec2 TexCoord;
 
-uniform sampler2DArray textureArray;
-uniform int layer;
+uniform sampler2D osdTexture;
 
 void main()
 {
-	FragColor = texture(textureArray, vec3(TexCoord, layer));
+    FragColor = texture(osdTexture, TexCoord);
 }
 )";
 
 const int MARGIN = 30;
 
-OsdRenderer::OsdRenderer()
+OsdRenderer::OsdRenderer(renderOptions_t options) : screen(DJI_ROWS, DJI_COLS), overlay(DJI_ROWS, DJI_COLS)
 {
-    this->screen = std::vector<std::vector<uint16_t>>(DJI_ROWS, std::vector<uint16_t>(DJI_COLS));
+    this->options = options;
 
     if (!glfwInit()) {
-        Log("Unable to init GLWF");
+        LogError("Unable to init GLWF");
         return;
     }
 
     if (glewInit() != GLEW_OK) {
-        Log("Unable to init GLEW");
+        LogError("Unable to init GLEW");
         return;
     }
 
     if (!this->createShader()) {
-        Log("Unable to create OSD Shader");
+        LogError("Unable to create OSD Shader");
         return;
     }
 
     this->intQuad();
+    if (this->options.renderMode == RENDER_MODE_GRID) {
+        this->createGridTexture();
+    }
+    if (this->options.windowMode != OSD_WINDOW_NONE) {
+        this->createWindowTarget();
+    }
 }
 
 OsdRenderer::~OsdRenderer()
 {
     glDeleteVertexArrays(1, &this->VAO);
+    glDeleteVertexArrays(1, &this->overlayVAO);
+    glDeleteBuffers(1, &this->overlayBuffer);
     glDeleteBuffers(1, &this->VBO);
     glDeleteBuffers(1, &this->EBO);
-    glDeleteProgram(this->shader);
-    glDeleteTextures(1, &textureArray);
+    for (GLsync fence : this->instanceFences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    glDeleteBuffers(1, &this->cellBuffer);
+    glDeleteBuffers(1, &this->instanceBuffer);
+    if (this->gridTexture) {
+        glDeleteTextures(1, &this->gridTexture);
+    }
+    if (this->windowFramebuffer) {
+        glDeleteFramebuffers(1, &this->windowFramebuffer);
+    }
+    if (this->windowTexture) {
+        glDeleteTextures(1, &this->windowTexture);
+    }
+    glDeleteProgram(this->shader.program);
+    glDeleteProgram(this->gridShader.program);
+    glDeleteProgram(this->windowShader.program);
 }
 
-GLuint OsdRenderer::compileShader(GLenum type, const char *source)
+GLuint OsdRenderer::compileShader(GLenum type, std::vector<const char*> sources)
 {
     GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, nullptr);
+    glShaderSource(shader, sources.size(), sources.data(), nullptr);
     glCompileShader(shader);
 
     int success;
@@ -84,63 +235,110 @@ GLuint OsdRenderer::compileShader(GLenum type, const char *source)
     if (!success) {
         char infoLog[512];
         glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        Log("Shader compilation failed: ", infoLog);
+        LogError("Shader compilation failed: ", infoLog);
     }
     return shader;
 }
 
-bool OsdRenderer::createShader()
+bool OsdRenderer::createProgram(glyphProgram_t &program, const char *vertexSource, std::vector<const char*> fragmentSources)
 {
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, {vertexSource});
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSources);
 
-    this->shader = glCreateProgram();
-    glAttachShader(this->shader, vertexShader);
-    glAttachShader(this->shader, fragmentShader);
-    glLinkProgram(this->shader);
+    program.program = glCreateProgram();
+    glAttachShader(program.program, vertexShader);
+    glAttachShader(program.program, fragmentShader);
+    glLinkProgram(program.program);
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
 
     int success;
-    glGetProgramiv(this->shader, GL_LINK_STATUS, &success);
+    glGetProgramiv(program.program, GL_LINK_STATUS, &success);
     if (!success) {
         char infoLog[512];
-        glGetProgramInfoLog(this->shader, 512, nullptr, infoLog);
-        Log("Shader program linking failed: ", infoLog);
+        glGetProgramInfoLog(program.program, 512, nullptr, infoLog);
+        LogError("Shader program linking failed: ", infoLog);
         return false;
     }
 
-    this->transformLoc = glGetUniformLocation(this->shader, "transform");
-    this->layerLoc = glGetUniformLocation(this->shader, "layer");
+    program.glyphModeLoc = glGetUniformLocation(program.program, "glyphMode");
+    program.tintLoc = glGetUniformLocation(program.program, "tint");
+    program.texScaleLoc = glGetUniformLocation(program.program, "texScale");
+    program.timeLoc = glGetUniformLocation(program.program, "time");
+    program.placementLoc = glGetUniformLocation(program.program, "placement");
+    return true;
+}
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+bool OsdRenderer::createShader()
+{
+    // The instanced program also draws the overlay in grid mode
+    if (!this->createProgram(this->shader, vertexShaderSource, {glyphShaderSource, fragmentShaderSource})) {
+        return false;
+    }
+    this->cellSizeLoc = glGetUniformLocation(this->shader.program, "cellSize");
 
+    if (this->options.renderMode == RENDER_MODE_GRID) {
+        if (!this->createProgram(this->gridShader, gridVertexShaderSource, {glyphShaderSource, gridFragmentShaderSource})) {
+            return false;
+        }
+
+        this->gridOriginLoc = glGetUniformLocation(this->gridShader.program, "gridOrigin");
+        this->gridExtentLoc = glGetUniformLocation(this->gridShader.program, "gridExtent");
+        this->gridSizeLoc = glGetUniformLocation(this->gridShader.program, "gridSize");
+        glUseProgram(this->gridShader.program);
+        glUniform1i(glGetUniformLocation(this->gridShader.program, "grid"), GRID_TEXTURE_UNIT);
+        glUseProgram(0);
+    }
     return true;
 }
 
 void OsdRenderer::intQuad()
 {
+    // Unit cell anchored at its top left corner, scaled by cellSize in the shader.
+    // Glyph layers are in image order (top row first), so V runs top to bottom
     float vertices[] = {
-        1.0f,  1.0f, 1.0f, 1.0f,  // right top
-        1.0f, -1.0f, 1.0f, 0.0f,  // right bottom
-       -1.0f, -1.0f, 0.0f, 0.0f,  // left bottom
-       -1.0f,  1.0f, 0.0f, 1.0f   // left top
+        1.0f,  0.0f, 1.0f, 0.0f,  // right top
+        1.0f, -1.0f, 1.0f, 1.0f,  // right bottom
+        0.0f, -1.0f, 0.0f, 1.0f,  // left bottom
+        0.0f,  0.0f, 0.0f, 0.0f   // left top
     };
     unsigned int indices[] = {
         0, 1, 3,  // first Triangle
         1, 2, 3   // second Triangle
     };
 
-    glGenVertexArrays(1, &this->VAO);
     glGenBuffers(1, &this->VBO);
     glGenBuffers(1, &this->EBO);
-
-    glBindVertexArray(this->VAO);
+    glGenBuffers(1, &this->cellBuffer);
+    glGenBuffers(1, &this->instanceBuffer);
+    glGenBuffers(1, &this->overlayBuffer);
 
     glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    this->createInstanceRing();
+    this->overlayLayers = std::vector<int32_t>(this->overlay.getRows() * this->overlay.getCols(), GLYPH_LAYER_NONE);
+    glBindBuffer(GL_ARRAY_BUFFER, this->overlayBuffer);
+    glBufferData(GL_ARRAY_BUFFER, this->overlayLayers.size() * sizeof(int32_t), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Both share the quad and the cell positions, only the glyph layers differ
+    this->VAO = this->createVertexArray(this->instanceBuffer);
+    this->overlayVAO = this->createVertexArray(this->overlayBuffer);
+}
+
+GLuint OsdRenderer::createVertexArray(GLuint instances)
+{
+    GLuint vertexArray;
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
 
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -148,100 +346,288 @@ void OsdRenderer::intQuad()
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, this->cellBuffer);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(2);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instances);
+    glVertexAttribIPointer(3, 1, GL_INT, sizeof(int32_t), (void*)0);
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(3);
+
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return vertexArray;
 }
 
-void OsdRenderer::loadTextureArray(std::vector<std::vector<uint8_t>> textures, int width, int height)
+void OsdRenderer::createGridTexture()
 {
-    if (!this->currentFontName.empty()) {
-        glDeleteTextures(1, &textureArray);
+    this->gridLayers = std::vector<uint16_t>(this->screen.getRows() * this->screen.getCols(), GRID_CELL_EMPTY);
+
+    XPLMGenerateTextureNumbers(reinterpret_cast<int*>(&this->gridTexture), 1);
+    XPLMBindTexture2d(this->gridTexture, 0);
+    // Integer textures can't be filtered, texelFetch ignores the filter anyway
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, this->screen.getCols(), this->screen.getRows(), 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, this->gridLayers.data());
+}
+
+void OsdRenderer::createWindowTarget()
+{
+    if (!this->createProgram(this->windowShader, windowVertexShaderSource, {windowFragmentShaderSource})) {
+        LogError("Unable to create OSD window shader");
+        return;
     }
+    this->windowRectLoc = glGetUniformLocation(this->windowShader.program, "windowRect");
+    this->modelviewLoc = glGetUniformLocation(this->windowShader.program, "modelview");
+    this->projectionLoc = glGetUniformLocation(this->windowShader.program, "projection");
+
+    // Window callbacks draw in window boxels, these map them to the current target
+    this->modelviewRef = XPLMFindDataRef("sim/graphics/view/modelview_matrix");
+    this->projectionRef = XPLMFindDataRef("sim/graphics/view/projection_matrix");
 
-    XPLMGenerateTextureNumbers(reinterpret_cast<int*>(&this->textureArray), 1);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, this->textureArray);
+    // Storage is allocated with the first layout
+    XPLMGenerateTextureNumbers(reinterpret_cast<int*>(&this->windowTexture), 1);
+    XPLMBindTexture2d(this->windowTexture, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    glGenFramebuffers(1, &this->windowFramebuffer);
+}
+
+void OsdRenderer::createInstanceRing()
+{
+    // Sized for the largest grid, so layout changes never reallocate
+    const size_t segmentSize = this->screen.getRows() * this->screen.getCols() * sizeof(int32_t);
+    this->instanceLayers = std::vector<int32_t>(this->screen.getRows() * this->screen.getCols(), GLYPH_LAYER_NONE);
 
-    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, width, height, textures.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer);
+    if (GLEW_ARB_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, INSTANCE_RING_SEGMENTS * segmentSize, nullptr, flags);
+        this->instanceMapping = static_cast<int32_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, INSTANCE_RING_SEGMENTS * segmentSize, flags));
+        if (this->instanceMapping) {
+            return;
+        }
 
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // Buffer storage is immutable, start over with a regular buffer
+        LogWarning("Unable to map instance buffer, falling back to buffer updates");
+        glDeleteBuffers(1, &this->instanceBuffer);
+        glGenBuffers(1, &this->instanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer);
+    }
+    glBufferData(GL_ARRAY_BUFFER, segmentSize, nullptr, GL_DYNAMIC_DRAW);
+}
 
-    for (size_t i = 0; i < textures.size(); i++) {
-        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, textures[i].data());
+void OsdRenderer::waitInstanceSegment(unsigned int segment)
+{
+    GLsync &fence = this->instanceFences[segment];
+    if (!fence) {
+        return;
     }
-    
-    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
 
-    this->textureWidth = width;
-    this->textureHeight = height;
+    // The segment was last drawn from two content changes ago, so this normally returns at once
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, INSTANCE_FENCE_TIMEOUT_NS);
+    if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+        LogWarning("Instance buffer fence not signalled, overwriting segment ", segment);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
 }
 
 void OsdRenderer::clearScreen()
 {
-    this->screen = std::vector<std::vector<uint16_t>>(DJI_ROWS, std::vector<uint16_t>(DJI_COLS));
+    this->screen.clear();
 }
 
 void OsdRenderer::setCharacter(int row, int col, uint16_t character)
 {
-    this->screen[row][col] = character;
+    this->screen.setCharacter(row, col, character);
+}
+
+void OsdRenderer::writeRow(int row, int col, std::span<const uint8_t> characters, uint8_t attributes)
+{
+    this->screen.writeRow(row, col, characters, attributes);
+}
+
+void OsdRenderer::setActiveGrid(int rows, int cols)
+{
+    this->screen.setActiveGrid(rows, cols);
+    this->overlay.setActiveGrid(rows, cols);
+}
+
+void OsdRenderer::clearOverlay()
+{
+    this->overlay.clear();
+}
+
+void OsdRenderer::clearOverlayRow(int row)
+{
+    this->overlay.clearRow(row);
+}
+
+void OsdRenderer::writeOverlayRow(int row, int col, std::span<const uint8_t> characters, uint8_t attributes)
+{
+    this->overlay.writeRow(row, col, characters, attributes);
 }
 
 void OsdRenderer::LoadFont(std::shared_ptr<FontBase> font)
 {
-    if (this->currentFontName != font->getName()) {
-        this->loadTextureArray(font->getTextures(), font->getCharWidth(), font->getCharHeight());
-        this->currentFontName = font->getName();
+    if (!this->fontTextures.empty() && this->fontTextures.front()->getFontName() == font->getName()) {
+        return;
+    }
+
+    for (std::list<std::unique_ptr<FontTexture>>::iterator it = this->fontTextures.begin(); it != this->fontTextures.end(); it++) {
+        if ((*it)->getFontName() == font->getName()) {
+            LogDebug("Font texture cache hit: ", font->getName());
+            this->fontTextures.splice(this->fontTextures.begin(), this->fontTextures, it);
+            return;
+        }
+    }
+
+    // Loading runs from the flight loop and menu callbacks, outside any GL state of ours, so the texture
+    // is created and the cache is trimmed by the next render()
+    this->fontTextures.push_front(std::make_unique<FontTexture>(font, this->options.glyphCacheSlots, this->options.textureFilter));
+    this->evictionPending = true;
+}
+
+bool OsdRenderer::isFontResident(std::shared_ptr<FontBase> font)
+{
+    // Sparse textures still upload from the font's glyphs
+    for (const std::unique_ptr<FontTexture> &texture : this->fontTextures) {
+        if (texture->getFontName() == font->getName()) {
+            return !texture->isSparse();
+        }
     }
+    return false;
 }
 
-void OsdRenderer::drawCharacter(int layer, float x, float y, int width, int height, int windowWidth, int windowHeight)
+bool OsdRenderer::needsFontGlyphs(std::shared_ptr<FontBase> font)
 {
-    const float w = width / static_cast<float>(windowWidth);
-    const float h = height / static_cast<float>(windowHeight);
+    // A worker is still copying from the glyphs
+    for (const std::unique_ptr<FontTexture> &texture : this->fontTextures) {
+        if (texture->getFontName() == font->getName()) {
+            return texture->isStreaming();
+        }
+    }
+    return false;
+}
 
-    glm::vec2 pos = pixelToWorldCoords(x, y, windowWidth, windowHeight);
-    
-    // 0,0 = Upper left
-    pos.x = pos.x + w;
-    pos.y = pos.y - h;
+FontTexture *OsdRenderer::getDisplayedTexture()
+{
+    for (const std::unique_ptr<FontTexture> &texture : this->fontTextures) {
+        if (texture->isReady()) {
+            return texture.get();
+        }
+    }
+    return nullptr;
+}
 
-    float transform[16] = {
-        w,      0.0f,   0.0f,   0.0f,   // normal width
-        0.0f,   h,      0.0f,   0.0f,   // normal height
-        0.0f,   0.0f,   1.0f,   0.0f,   // ---
-        pos.x,  pos.y,  0.0f,   1.0f    // position
-    };
+void OsdRenderer::evictFontTextures()
+{
+    size_t size = 0;
+    for (const std::unique_ptr<FontTexture> &texture : this->fontTextures) {
+        size += texture->getByteSize();
+    }
 
-    glUniformMatrix4fv(transformLoc, 1, GL_FALSE, transform);
-    glUniform1i(layerLoc, layer);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    // The requested texture and the one displayed until it has been streamed are kept
+    FontTexture *displayed = this->getDisplayedTexture();
+    std::list<std::unique_ptr<FontTexture>>::iterator it = std::prev(this->fontTextures.end());
+    while (size > this->options.textureCacheBudget && it != this->fontTextures.begin()) {
+        std::list<std::unique_ptr<FontTexture>>::iterator previous = std::prev(it);
+        if (it->get() != displayed) {
+            LogDebug("Evicting font texture: ", (*it)->getFontName());
+            size -= (*it)->getByteSize();
+            this->fontTextures.erase(it);
+        }
+        it = previous;
+    }
 }
 
-glm::vec2 OsdRenderer::pixelToWorldCoords(int x, int y, int width, int heigth)
+glyphMode_e OsdRenderer::getGlyphMode(glyphFormat_e format)
 {
-    return glm::vec2(
-        ((x + 0.5f) / width) * 2.0f - 1.0f,
-        1.0f - ((y + 0.5f) / heigth) * 2.0f
-    );
+    switch (format) {
+        case GLYPH_FORMAT_LA8:
+        case GLYPH_FORMAT_RGTC2:
+            return GLYPH_MODE_LUMINANCE_ALPHA;
+        case GLYPH_FORMAT_SDF:
+            return GLYPH_MODE_SDF;
+        default:
+            return GLYPH_MODE_RGBA;
+    }
 }
 
-void OsdRenderer::render(int rows, int cols)
+static void receiveMonitorBounds(int index, int left, int top, int right, int bottom, void *refcon)
 {
-    glUseProgram(this->shader);
-    glBindVertexArray(this->VAO);
-    
-    int windowWidth, windowHeight;
-    XPLMGetScreenSize(&windowWidth, &windowHeight);
+    std::vector<std::pair<int, osdArea_t>> *monitors = static_cast<std::vector<std::pair<int, osdArea_t>>*>(refcon);
+    monitors->push_back({index, {left, top, right - left, top - bottom}});
+}
+
+osdArea_t OsdRenderer::getTargetArea(int windowWidth, int windowHeight)
+{
+    osdArea_t area = {0, 0, windowWidth, windowHeight};
+    if (this->placement.monitor >= 0) {
+        std::vector<std::pair<int, osdArea_t>> monitors;
+        XPLMGetAllMonitorBoundsGlobal(&receiveMonitorBounds, &monitors);
+
+        int left, top, right, bottom;
+        XPLMGetScreenBoundsGlobal(&left, &top, &right, &bottom);
+        for (const std::pair<int, osdArea_t> &monitor : monitors) {
+            if (monitor.first != this->placement.monitor || right <= left || top <= bottom) {
+                continue;
+            }
+
+            // Global bounds have y up and may span several monitors, the window is scaled onto them
+            const float scaleX = static_cast<float>(windowWidth) / (right - left);
+            const float scaleY = static_cast<float>(windowHeight) / (top - bottom);
+            area.x = (monitor.second.x - left) * scaleX;
+            area.y = (top - monitor.second.y) * scaleY;
+            area.width = monitor.second.width * scaleX;
+            area.height = monitor.second.height * scaleY;
+            break;
+        }
+    }
+
+    const int insetX = area.width * this->placement.safeArea / 100.0f;
+    const int insetY = area.height * this->placement.safeArea / 100.0f;
+    area.x += insetX;
+    area.y += insetY;
+    area.width = std::max(1, area.width - 2 * insetX);
+    area.height = std::max(1, area.height - 2 * insetY);
+    return area;
+}
+
+bool OsdRenderer::updateLayout(int windowWidth, int windowHeight, const osdArea_t &area, int rows, int cols, FontTexture *fontTexture)
+{
+    const unsigned int textureWidth = fontTexture->getWidth();
+    const unsigned int textureHeight = fontTexture->getHeight();
+    osdLayout_t &layout = this->layout;
+    if (layout.windowWidth == windowWidth && layout.windowHeight == windowHeight && layout.areaWidth == area.width && layout.areaHeight == area.height &&
+        layout.rows == rows && layout.cols == cols && layout.glyphWidth == textureWidth && layout.glyphHeight == textureHeight) {
+        return false;
+    }
+
+    layout.windowWidth = windowWidth;
+    layout.windowHeight = windowHeight;
+    layout.areaWidth = area.width;
+    layout.areaHeight = area.height;
+    layout.rows = rows;
+    layout.cols = cols;
+    layout.glyphWidth = textureWidth;
+    layout.glyphHeight = textureHeight;
 
-    const float textureAspectRatio = static_cast<float>(this->textureWidth) / static_cast<float>(this ->textureHeight);
+    const float textureAspectRatio = static_cast<float>(textureWidth) / static_cast<float>(textureHeight);
 
-    int cellWidth = windowWidth / this->textureWidth ;
-    int cellHeight = windowHeight / textureAspectRatio; 
+    int cellWidth = area.width / textureWidth ;
+    int cellHeight = area.height / textureAspectRatio; 
 
-    const int avaiableWidth = windowWidth - 2 * MARGIN;
-    const int avaiableHeight = windowHeight - 2 * MARGIN;
+    const int avaiableWidth = area.width - 2 * MARGIN;
+    const int avaiableHeight = area.height - 2 * MARGIN;
 
     if (cellWidth * cols > avaiableWidth) {
         cellWidth = avaiableWidth / cols;
@@ -253,22 +639,413 @@ void OsdRenderer::render(int rows, int cols)
         cellWidth = cellHeight * textureAspectRatio;
     }
           
-    int xOffset = (windowWidth - cellWidth * cols) / 2.0f ;
-    int yOffset = (windowHeight - cellHeight * rows) / 2.0f;
-    for (int y = 0; y < rows; y++) {
-        for (int x = 0; x < cols; x++) {
-            
-            int character = this->screen[y][x];
+    // Centred in the window, placement moves it from there
+    layout.cellWidth = cellWidth;
+    layout.cellHeight = cellHeight;
+    layout.xOffset = (windowWidth - cellWidth * cols) / 2.0f ;
+    layout.yOffset = (windowHeight - cellHeight * rows) / 2.0f;
+    return true;
+}
+
+void OsdRenderer::updatePlacementTransform(const osdArea_t &area)
+{
+    const osdLayout_t &layout = this->layout;
+    float anchorX = 0.5f;
+    float anchorY = 0.5f;
+    switch (this->placement.anchor) {
+        case OSD_ANCHOR_TOP_LEFT:     anchorX = 0.0f; anchorY = 0.0f; break;
+        case OSD_ANCHOR_TOP:          anchorY = 0.0f; break;
+        case OSD_ANCHOR_TOP_RIGHT:    anchorX = 1.0f; anchorY = 0.0f; break;
+        case OSD_ANCHOR_LEFT:         anchorX = 0.0f; break;
+        case OSD_ANCHOR_RIGHT:        anchorX = 1.0f; break;
+        case OSD_ANCHOR_BOTTOM_LEFT:  anchorX = 0.0f; anchorY = 1.0f; break;
+        case OSD_ANCHOR_BOTTOM:       anchorY = 1.0f; break;
+        case OSD_ANCHOR_BOTTOM_RIGHT: anchorX = 1.0f; anchorY = 1.0f; break;
+        default: break;
+    }
+
+    // Anchor points in window pixels of the centred OSD and of the target area, inset by the margin
+    const float osdX = layout.xOffset + anchorX * layout.cellWidth * layout.cols;
+    const float osdY = layout.yOffset + anchorY * layout.cellHeight * layout.rows;
+    const float targetX = area.x + MARGIN + anchorX * (area.width - 2 * MARGIN) + this->placement.offsetX;
+    const float targetY = area.y + MARGIN + anchorY * (area.height - 2 * MARGIN) + this->placement.offsetY;
+
+    // p' = (p - osd) * scale + target, in NDC
+    const float scale = this->placement.scale;
+    const glm::vec2 osd = glm::vec2(osdX * 2.0f / layout.windowWidth - 1.0f, 1.0f - osdY * 2.0f / layout.windowHeight);
+    const glm::vec2 target = glm::vec2(targetX * 2.0f / layout.windowWidth - 1.0f, 1.0f - targetY * 2.0f / layout.windowHeight);
+    this->placementTransform = glm::vec4(scale, scale, target.x - osd.x * scale, target.y - osd.y * scale);
+}
+
+void OsdRenderer::setPlacement(osdPlacement_t placement)
+{
+    this->placement = placement;
+    this->tint.w = std::clamp(placement.opacity, 0.0f, 1.0f);
+    this->placementChanged = true;
+    // Opacity is baked into the window texture
+    this->windowTextureValid = false;
+}
+
+void OsdRenderer::updateCellBuffer()
+{
+    const osdLayout_t &layout = this->layout;
+    std::vector<float> cells;
+    cells.reserve(layout.rows * layout.cols * 2);
+    for (int y = 0; y < layout.rows; y++) {
+        for (int x = 0; x < layout.cols; x++) {
+            // Top left corner of the cell
+            cells.push_back((x * layout.cellWidth + layout.xOffset) * 2.0f / layout.windowWidth - 1.0f);
+            cells.push_back(1.0f - (y * layout.cellHeight + layout.yOffset) * 2.0f / layout.windowHeight);
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->cellBuffer);
+    glBufferData(GL_ARRAY_BUFFER, cells.size() * sizeof(float), cells.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void OsdRenderer::resolveLayers(FontTexture *fontTexture, const OsdScreen &screen, std::vector<int32_t> &layers, int firstRow, int lastRow)
+{
+    const osdLayout_t &layout = this->layout;
+    for (int y = firstRow; y <= lastRow; y++) {
+        for (int x = 0; x < layout.cols; x++) {
+            uint16_t character = screen.getCharacter(y, x);
+            int32_t &layer = layers[y * layout.cols + x];
             if (character == 0x20 || character == 0x00) {
-                continue;
+                layer = GLYPH_LAYER_NONE;
+            } else {
+                layer = fontTexture->getLayer(character);
+                if (layer >= 0 && screen.isBlinking(y, x)) {
+                    layer |= LAYER_BLINK;
+                }
             }
-            
-            float posX = static_cast<float>(x * cellWidth + xOffset);
-            float posY = static_cast<float>(y * cellHeight + yOffset); 
-            this->drawCharacter(character, posX, posY, cellWidth, cellHeight, windowWidth, windowHeight);         
         }
     }
-    
-    glBindVertexArray(0);
-    glUseProgram(0); 
+}
+
+void OsdRenderer::uploadInstances(int firstRow, int lastRow)
+{
+    const std::vector<int32_t> &layers = this->instanceLayers;
+    if (this->instanceMapping) {
+        // Written straight into GPU visible memory, the segments still in flight are left alone.
+        // A reused segment is several updates old, so it always gets the whole grid.
+        this->instanceSegment = (this->instanceSegment + 1) % INSTANCE_RING_SEGMENTS;
+        this->waitInstanceSegment(this->instanceSegment);
+        const size_t offset = this->instanceSegment * layers.size();
+        memcpy(this->instanceMapping + offset, layers.data(), this->layout.rows * this->layout.cols * sizeof(int32_t));
+
+        // Expects the VAO to be bound
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer);
+        glVertexAttribIPointer(3, 1, GL_INT, sizeof(int32_t), (void*)(offset * sizeof(int32_t)));
+    } else {
+        const size_t offset = firstRow * this->layout.cols;
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(int32_t), (lastRow - firstRow + 1) * this->layout.cols * sizeof(int32_t), layers.data() + offset);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void OsdRenderer::uploadGrid(GlStateScope &state, int firstRow, int lastRow)
+{
+    const osdLayout_t &layout = this->layout;
+    const int stride = this->screen.getCols();
+
+    state.activeTexture(GL_TEXTURE0 + GRID_TEXTURE_UNIT);
+    // Runs of changed rows go up as one sub image, unchanged rows are skipped
+    int firstChanged = -1;
+    for (int y = firstRow; y <= lastRow + 1; y++) {
+        bool changed = false;
+        for (int x = 0; y <= lastRow && x < layout.cols; x++) {
+            const int32_t layer = this->instanceLayers[y * layout.cols + x];
+            const uint16_t cell = layer < 0 ? GRID_CELL_EMPTY : static_cast<uint16_t>(layer);
+            if (this->gridLayers[y * stride + x] != cell) {
+                this->gridLayers[y * stride + x] = cell;
+                changed = true;
+            }
+        }
+
+        if (changed && firstChanged < 0) {
+            firstChanged = y;
+        } else if (!changed && firstChanged >= 0) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstChanged, stride, y - firstChanged, GL_RED_INTEGER, GL_UNSIGNED_SHORT, &this->gridLayers[firstChanged * stride]);
+            firstChanged = -1;
+        }
+    }
+    state.activeTexture(GL_TEXTURE0);
+}
+
+void OsdRenderer::setGlyphUniforms(const glyphProgram_t &program, FontTexture *fontTexture)
+{
+    // Block compressed layers are padded, only the glyph area is sampled
+    const glm::vec2 texScale = glm::vec2(fontTexture->getWidth() / static_cast<float>(fontTexture->getStorageWidth()), fontTexture->getHeight() / static_cast<float>(fontTexture->getStorageHeight()));
+    glUniform1i(program.glyphModeLoc, getGlyphMode(fontTexture->getFormat()));
+    glUniform4fv(program.tintLoc, 1, glm::value_ptr(this->tint));
+    glUniform2fv(program.texScaleLoc, 1, glm::value_ptr(texScale));
+    // Blinking runs in the shaders, wrapped so the float keeps millisecond precision
+    glUniform1f(program.timeLoc, (getTickCount() % SHADER_TIME_WRAP_MS) / 1000.0f);
+    glUniform4fv(program.placementLoc, 1, glm::value_ptr(this->placementTransform));
+}
+
+void OsdRenderer::uploadOverlay()
+{
+    const size_t count = this->layout.rows * this->layout.cols;
+    this->overlayVisible = std::any_of(this->overlayLayers.begin(), this->overlayLayers.begin() + count, [](int32_t layer) { return layer >= 0; });
+    if (!this->overlayVisible) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->overlayBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(int32_t), this->overlayLayers.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void OsdRenderer::drawGrid(GlStateScope &state, FontTexture *fontTexture)
+{
+    const osdLayout_t &layout = this->layout;
+    const glm::vec2 origin = glm::vec2(layout.xOffset * 2.0f / layout.windowWidth - 1.0f, 1.0f - layout.yOffset * 2.0f / layout.windowHeight);
+    const glm::vec2 extent = glm::vec2(layout.cellWidth * layout.cols * 2.0f / layout.windowWidth, layout.cellHeight * layout.rows * 2.0f / layout.windowHeight);
+
+    state.bindVertexArray(this->VAO);
+    state.useProgram(this->gridShader.program);
+    this->setGlyphUniforms(this->gridShader, fontTexture);
+    glUniform2fv(this->gridOriginLoc, 1, glm::value_ptr(origin));
+    glUniform2fv(this->gridExtentLoc, 1, glm::value_ptr(extent));
+    glUniform2f(this->gridSizeLoc, layout.cols, layout.rows);
+
+    // A single quad however many cells are filled
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
+
+void OsdRenderer::drawInstances(GlStateScope &state, FontTexture *fontTexture, GLuint vertexArray)
+{
+    const osdLayout_t &layout = this->layout;
+    const glm::vec2 cellSize = glm::vec2(layout.cellWidth * 2.0f / layout.windowWidth, layout.cellHeight * 2.0f / layout.windowHeight);
+
+    state.bindVertexArray(vertexArray);
+    state.useProgram(this->shader.program);
+    this->setGlyphUniforms(this->shader, fontTexture);
+    glUniform2fv(this->cellSizeLoc, 1, glm::value_ptr(cellSize));
+
+    // One instance per cell, the per frame cost doesn't depend on the grid size
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, layout.rows * layout.cols);
+}
+
+void OsdRenderer::render(int rows, int cols)
+{
+    int windowWidth, windowHeight;
+    XPLMGetScreenSize(&windowWidth, &windowHeight);
+
+    // Everything from here on, texture uploads included, runs inside the OSD's own GL state
+    GlStateScope state;
+    if (this->evictionPending) {
+        this->evictFontTextures();
+        this->evictionPending = false;
+    }
+    for (const std::unique_ptr<FontTexture> &texture : this->fontTextures) {
+        texture->update(state);
+    }
+
+    FontTexture *fontTexture = this->getDisplayedTexture();
+    if (!fontTexture || rows <= 0 || cols <= 0) {
+        return;
+    }
+    rows = std::min<int>(rows, this->screen.getRows());
+    cols = std::min<int>(cols, this->screen.getCols());
+
+    const bool areaChanged = this->placementChanged || windowWidth != this->targetWindowWidth || windowHeight != this->targetWindowHeight;
+    if (areaChanged) {
+        this->targetArea = this->getTargetArea(windowWidth, windowHeight);
+        this->targetWindowWidth = windowWidth;
+        this->targetWindowHeight = windowHeight;
+        this->placementChanged = false;
+    }
+    const osdArea_t &area = this->targetArea;
+
+    bool layoutChanged = this->updateLayout(windowWidth, windowHeight, area, rows, cols, fontTexture);
+    if (layoutChanged) {
+        this->updateCellBuffer();
+    }
+    if (layoutChanged || areaChanged) {
+        this->updatePlacementTransform(area);
+    }
+
+    // The main VAO is bound for the instance ring, which repoints its layer attribute
+    state.bindVertexArray(this->VAO);
+    state.bindTextureArray(fontTexture->getTexture());
+    const bool textureChanged = this->resolvedTextureId != fontTexture->getId();
+    bool screenChanged = layoutChanged || textureChanged || this->screen.isDirty();
+    bool overlayChanged = layoutChanged || textureChanged || this->overlay.isDirty();
+    // Every visible cell of a sparse texture is resolved in the same frame, so it never recycles a slot that is still on screen
+    if (fontTexture->isSparse() && (screenChanged || overlayChanged)) {
+        screenChanged = overlayChanged = true;
+    }
+
+    int firstRow = 0;
+    int lastRow = rows - 1;
+    unsigned int dirtyFirst, dirtyLast;
+    if (!layoutChanged && !textureChanged && !fontTexture->isSparse() && this->screen.getDirtyRows(dirtyFirst, dirtyLast)) {
+        firstRow = dirtyFirst;
+        lastRow = std::min<int>(dirtyLast, rows - 1);
+    }
+    screenChanged = screenChanged && firstRow <= lastRow;
+
+    if (screenChanged || overlayChanged) {
+        fontTexture->beginFrame(state);
+        if (screenChanged) {
+            this->resolveLayers(fontTexture, this->screen, this->instanceLayers, firstRow, lastRow);
+        }
+        if (overlayChanged) {
+            this->resolveLayers(fontTexture, this->overlay, this->overlayLayers, 0, rows - 1);
+        }
+        fontTexture->endFrame();
+
+        this->screen.clearDirty();
+        this->overlay.clearDirty();
+        this->resolvedTextureId = fontTexture->getId();
+    }
+    if (this->options.renderMode == RENDER_MODE_GRID) {
+        state.bindTexture2d(this->gridTexture, GRID_TEXTURE_UNIT);
+        if (screenChanged) {
+            this->uploadGrid(state, firstRow, lastRow);
+        }
+    } else if (screenChanged) {
+        this->uploadInstances(firstRow, lastRow);
+    }
+
+    // The flight controller's content is neither cleared nor redrawn for overlay changes
+    if (overlayChanged) {
+        this->uploadOverlay();
+    }
+
+    int drawCalls = 0;
+    if (this->options.mainView || !this->windowVisible) {
+        state.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        if (this->placement.safeArea > 0.0f || this->placement.monitor >= 0) {
+            // The area is in boxels, the scissor box in pixels of the target X-Plane draws into, whose origin is bottom left
+            const GLint *viewport = state.getViewport();
+            const float scaleX = static_cast<float>(viewport[2]) / windowWidth;
+            const float scaleY = static_cast<float>(viewport[3]) / windowHeight;
+            state.setScissor(viewport[0] + area.x * scaleX, viewport[1] + (windowHeight - area.y - area.height) * scaleY, area.width * scaleX, area.height * scaleY);
+        }
+        drawCalls += this->drawLayers(state, fontTexture);
+    }
+    if (this->windowFramebuffer && this->windowVisible) {
+        drawCalls += this->updateWindowTexture(state, fontTexture, screenChanged || overlayChanged);
+    }
+
+    // After every pass that reads the current segment
+    if (this->options.renderMode == RENDER_MODE_INSTANCED && this->instanceMapping) {
+        GLsync &fence = this->instanceFences[this->instanceSegment];
+        if (fence) {
+            glDeleteSync(fence);
+        }
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    PerfCounters::instance()->set(PERF_DRAW_CALLS_PER_FRAME, drawCalls);
+}
+
+int OsdRenderer::drawLayers(GlStateScope &state, FontTexture *fontTexture)
+{
+    if (this->options.renderMode == RENDER_MODE_GRID) {
+        this->drawGrid(state, fontTexture);
+    } else {
+        this->drawInstances(state, fontTexture, this->VAO);
+    }
+
+    if (!this->overlayVisible) {
+        return 1;
+    }
+    this->drawInstances(state, fontTexture, this->overlayVAO);
+    return 2;
+}
+
+int OsdRenderer::updateWindowTexture(GlStateScope &state, FontTexture *fontTexture, bool contentChanged)
+{
+    const osdLayout_t &layout = this->layout;
+    const int width = layout.cellWidth * layout.cols;
+    const int height = layout.cellHeight * layout.rows;
+    if (width <= 0 || height <= 0) {
+        return 0;
+    }
+
+    // Blinking runs in the shaders, the texture holds one phase at a time
+    const int blinkPhase = (getTickCount() % SHADER_TIME_WRAP_MS) / BLINK_HALF_PERIOD_MS % 2;
+    if (width != this->windowTextureWidth || height != this->windowTextureHeight) {
+        state.bindTexture2d(this->windowTexture, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        this->windowTextureWidth = width;
+        this->windowTextureHeight = height;
+        this->windowTextureValid = false;
+
+        state.bindFramebuffer(this->windowFramebuffer, width, height);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->windowTexture, 0);
+        if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            LogError("OSD window framebuffer incomplete, window stays empty");
+            glDeleteFramebuffers(1, &this->windowFramebuffer);
+            this->windowFramebuffer = 0;
+            return 0;
+        }
+    } else if (this->windowTextureValid && !contentChanged && blinkPhase == this->windowBlinkPhase) {
+        return 0;
+    }
+
+    state.bindFramebuffer(this->windowFramebuffer, width, height);
+    state.disableScissor();
+    const GLfloat transparent[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    glClearBufferfv(GL_COLOR, 0, transparent);
+    // Alpha accumulates as well, the window composites the result as premultiplied
+    state.setBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Maps the centred OSD onto the whole texture, placement only applies to the main view
+    const glm::vec4 placementTransform = this->placementTransform;
+    const float scaleX = static_cast<float>(layout.windowWidth) / width;
+    const float scaleY = static_cast<float>(layout.windowHeight) / height;
+    const float left = layout.xOffset * 2.0f / layout.windowWidth - 1.0f;
+    const float bottom = 1.0f - (layout.yOffset + height) * 2.0f / layout.windowHeight;
+    this->placementTransform = glm::vec4(scaleX, scaleY, -1.0f - left * scaleX, -1.0f - bottom * scaleY);
+    const int drawCalls = this->drawLayers(state, fontTexture);
+    this->placementTransform = placementTransform;
+
+    this->windowTextureValid = true;
+    this->windowBlinkPhase = blinkPhase;
+    return drawCalls;
+}
+
+void OsdRenderer::setWindowVisible(bool visible)
+{
+    // The texture wasn't updated while the window was hidden
+    if (visible && !this->windowVisible) {
+        this->windowTextureValid = false;
+    }
+    this->windowVisible = visible;
+}
+
+void OsdRenderer::drawWindow(int left, int top, int right, int bottom)
+{
+    if (!this->windowTextureValid || right <= left || top <= bottom) {
+        return;
+    }
+
+    // Largest rectangle of the OSD's aspect ratio, centred in the window
+    const float scale = std::min(static_cast<float>(right - left) / this->windowTextureWidth, static_cast<float>(top - bottom) / this->windowTextureHeight);
+    const float width = this->windowTextureWidth * scale;
+    const float height = this->windowTextureHeight * scale;
+    const glm::vec4 rect = glm::vec4(left + (right - left - width) / 2.0f, top - (top - bottom - height) / 2.0f, width, height);
+
+    float modelview[16];
+    float projection[16];
+    XPLMGetDatavf(this->modelviewRef, modelview, 0, 16);
+    XPLMGetDatavf(this->projectionRef, projection, 0, 16);
+
+    GlStateScope state;
+    state.useProgram(this->windowShader.program);
+    state.bindVertexArray(this->VAO);
+    state.bindTexture2d(this->windowTexture, 0);
+    state.setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glUniform4fv(this->windowRectLoc, 1, glm::value_ptr(rect));
+    glUniformMatrix4fv(this->modelviewLoc, 1, GL_FALSE, modelview);
+    glUniformMatrix4fv(this->projectionLoc, 1, GL_FALSE, projection);
+
+    // The second view costs a single quad, the glyphs were drawn into the texture by render()
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 }
@@ -3,40 +3,234 @@
 #include "platform.h"
 
 #include "fontBase.h"
+#include "fontTexture.h"
+#include "osdScreen.h"
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <XPLMDataAccess.h>
 #include <vector>
+#include <list>
+#include <span>
+
+#define INSTANCE_RING_SEGMENTS 3
+#define INSTANCE_FENCE_TIMEOUT_NS 1000000000
+#define GRID_CELL_EMPTY 0xFFFF
+// Packed into the glyph layer of a cell, layers stay below 0x8000
+#define LAYER_BLINK 0x8000
+// A whole number of blink periods
+#define SHADER_TIME_WRAP_MS 60000
+#define GRID_TEXTURE_UNIT 1
+// Half a period of the shaders' BLINK_FREQUENCY
+#define BLINK_HALF_PERIOD_MS 200
+
+typedef enum {
+    GLYPH_MODE_RGBA = 0,
+    GLYPH_MODE_LUMINANCE_ALPHA = 1,
+    GLYPH_MODE_SDF = 2,
+} glyphMode_e;
+
+typedef enum {
+    // One instanced quad per cell
+    RENDER_MODE_INSTANCED = 0,
+    // One quad over the whole grid, the fragment shader looks the glyph up in a grid texture
+    RENDER_MODE_GRID = 1,
+} renderMode_e;
+
+typedef enum {
+    OSD_WINDOW_NONE = 0,
+    // Decorated X-Plane window inside the main window
+    OSD_WINDOW_FLOATING = 1,
+    // Operating system window, can be moved to another monitor
+    OSD_WINDOW_POPOUT = 2,
+} osdWindowMode_e;
+
+typedef struct {
+    renderMode_e renderMode = RENDER_MODE_INSTANCED;
+    textureFilter_e textureFilter = TEXTURE_FILTER_LINEAR;
+    // Layers of the sparse glyph cache, 0 uploads whole fonts
+    unsigned int glyphCacheSlots = 0;
+    // GPU memory kept for recently used fonts, the active one is always resident
+    size_t textureCacheBudget = 16 * 1024 * 1024;
+    // Performance counters in the bottom row of the overlay
+    bool statsHud = false;
+    // Second view of the OSD in an X-Plane window, drawn from a cached texture
+    osdWindowMode_e windowMode = OSD_WINDOW_NONE;
+    // Off leaves the OSD to the window only
+    bool mainView = true;
+} renderOptions_t;
+
+typedef enum {
+    OSD_ANCHOR_CENTER = 0,
+    OSD_ANCHOR_TOP_LEFT,
+    OSD_ANCHOR_TOP,
+    OSD_ANCHOR_TOP_RIGHT,
+    OSD_ANCHOR_LEFT,
+    OSD_ANCHOR_RIGHT,
+    OSD_ANCHOR_BOTTOM_LEFT,
+    OSD_ANCHOR_BOTTOM,
+    OSD_ANCHOR_BOTTOM_RIGHT,
+} osdAnchor_e;
+
+typedef struct {
+    osdAnchor_e anchor = OSD_ANCHOR_CENTER;
+    // Pixels, right and down
+    int offsetX = 0;
+    int offsetY = 0;
+    // Relative to the size that fits the target area
+    float scale = 1.0f;
+    float opacity = 1.0f;
+    // Percent of the target area cut off at each side, the OSD is fitted into and cropped to the rest
+    float safeArea = 0.0f;
+    // X-Plane monitor to place the OSD on, -1 for the whole window
+    int monitor = -1;
+} osdPlacement_t;
+
+// Window pixels, top left origin
+typedef struct {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+} osdArea_t;
+
+// Cell geometry for one window size, grid size and glyph size, only recomputed when one of them changes
+typedef struct {
+    int windowWidth = 0;
+    int windowHeight = 0;
+    int areaWidth = 0;
+    int areaHeight = 0;
+    int rows = 0;
+    int cols = 0;
+    unsigned int glyphWidth = 0;
+    unsigned int glyphHeight = 0;
+    int cellWidth = 0;
+    int cellHeight = 0;
+    int xOffset = 0;
+    int yOffset = 0;
+} osdLayout_t;
+
+typedef struct {
+    GLuint program = 0;
+    GLint glyphModeLoc = -1;
+    GLint tintLoc = -1;
+    GLint texScaleLoc = -1;
+    GLint timeLoc = -1;
+    GLint placementLoc = -1;
+} glyphProgram_t;
+
+class GlStateScope;
 
 class OsdRenderer {
     private:
-        std::vector<std::vector<uint16_t>> screen;
-        GLuint compileShader(GLenum type, const char* source);
+        OsdScreen screen;
+        // Plugin generated messages, drawn over the flight controller's screen in a pass of its own
+        OsdScreen overlay;
+        osdLayout_t layout;
+        GLuint compileShader(GLenum type, std::vector<const char*> sources);
+        bool createProgram(glyphProgram_t &program, const char *vertexSource, std::vector<const char*> fragmentSources);
         bool createShader();
         void intQuad();
-        void loadTextureArray(std::vector<std::vector<uint8_t>> textures,  int width, int height);
-        void drawCharacter(int layer, float x, float y, int width, int height, int windowWidth, int windowHeight);
+        GLuint createVertexArray(GLuint instances);
+        void createGridTexture();
+        void createWindowTarget();
+        void evictFontTextures();
+        FontTexture *getDisplayedTexture();
+        osdArea_t getTargetArea(int windowWidth, int windowHeight);
+        bool updateLayout(int windowWidth, int windowHeight, const osdArea_t &area, int rows, int cols, FontTexture *fontTexture);
+        void updatePlacementTransform(const osdArea_t &area);
+        void updateCellBuffer();
+        void resolveLayers(FontTexture *fontTexture, const OsdScreen &screen, std::vector<int32_t> &layers, int firstRow, int lastRow);
+        void uploadInstances(int firstRow, int lastRow);
+        void uploadGrid(GlStateScope &state, int firstRow, int lastRow);
+        void uploadOverlay();
+        void drawGrid(GlStateScope &state, FontTexture *fontTexture);
+        void drawInstances(GlStateScope &state, FontTexture *fontTexture, GLuint vertexArray);
+        int drawLayers(GlStateScope &state, FontTexture *fontTexture);
+        int updateWindowTexture(GlStateScope &state, FontTexture *fontTexture, bool contentChanged);
+        void setGlyphUniforms(const glyphProgram_t &program, FontTexture *fontTexture);
+        void createInstanceRing();
+        void waitInstanceSegment(unsigned int segment);
         
-        uint textureWidth = 0;
-        uint textureHeight = 0;
-        std::string currentFontName = "";
-        GLuint shader;
+        renderOptions_t options;
+        // Most recently used first, the first ready one is drawn, so a streaming texture replaces the old one only once complete
+        std::list<std::unique_ptr<FontTexture>> fontTextures;
+        bool evictionPending = false;
+        glyphProgram_t shader;
+        glyphProgram_t gridShader;
         GLuint VAO;
         GLuint VBO;
         GLuint EBO;
-        GLuint textureArray;
-        GLint transformLoc;
-        GLint layerLoc;
+        // Per instance attributes: cell positions change with the layout, glyph layers with the content
+        GLuint cellBuffer;
+        GLuint instanceBuffer;
+        // Texture the current layers were resolved against
+        uint32_t resolvedTextureId = 0;
+        // Persistently mapped ring of one full grid per segment, a segment is only
+        // rewritten after the fence of its last draw signalled. Null without ARB_buffer_storage.
+        int32_t *instanceMapping = nullptr;
+        GLsync instanceFences[INSTANCE_RING_SEGMENTS] = {};
+        unsigned int instanceSegment = 0;
+        std::vector<int32_t> instanceLayers;
+        GLint cellSizeLoc;
+        // Grid mode: one R16UI texel per cell holding the glyph layer, a CPU copy finds the changed rows
+        GLuint gridTexture = 0;
+        std::vector<uint16_t> gridLayers;
+        GLint gridOriginLoc;
+        GLint gridExtentLoc;
+        GLint gridSizeLoc;
+        GLuint overlayVAO;
+        GLuint overlayBuffer;
+        std::vector<int32_t> overlayLayers;
+        bool overlayVisible = false;
+        // Multiplied with every texel, colours luminance + alpha fonts, alpha is the placement's opacity
+        glm::vec4 tint = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        osdPlacement_t placement;
+        bool windowVisible = false;
+        // Monitor bounds and safe area inset, only recomputed when the window size or the placement changes
+        osdArea_t targetArea;
+        int targetWindowWidth = 0;
+        int targetWindowHeight = 0;
+        bool placementChanged = true;
+        // Scale in xy, translation in zw, applied to the centred layout in the vertex shaders
+        glm::vec4 placementTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+        // Window mode: the OSD at its layout size, only redrawn when the content, the layout or the blink
+        // phase changes, so the window costs one textured quad per frame
+        GLuint windowFramebuffer = 0;
+        GLuint windowTexture = 0;
+        int windowTextureWidth = 0;
+        int windowTextureHeight = 0;
+        bool windowTextureValid = false;
+        int windowBlinkPhase = -1;
+        glyphProgram_t windowShader;
+        GLint windowRectLoc;
+        GLint modelviewLoc;
+        GLint projectionLoc;
+        XPLMDataRef modelviewRef = nullptr;
+        XPLMDataRef projectionRef = nullptr;
         
-        static glm::vec2 pixelToWorldCoords(int x, int y, int width, int heigth);
+        static glyphMode_e getGlyphMode(glyphFormat_e format);
 
     public:
-        OsdRenderer();
+        OsdRenderer(renderOptions_t options);
         ~OsdRenderer();
 
         void clearScreen();
         void setCharacter(int row, int col, uint16_t character);
+        void writeRow(int row, int col, std::span<const uint8_t> characters, uint8_t attributes);
+        void setActiveGrid(int rows, int cols);
+        void clearOverlay();
+        void clearOverlayRow(int row);
+        void writeOverlayRow(int row, int col, std::span<const uint8_t> characters, uint8_t attributes);
         void LoadFont(std::shared_ptr<FontBase> font);
+        bool isFontResident(std::shared_ptr<FontBase> font);
+        bool needsFontGlyphs(std::shared_ptr<FontBase> font);
         void render(int rows, int cols);
+        // Only changes uniforms and, for a different fit, the cell positions, fonts stay loaded
+        void setPlacement(osdPlacement_t placement);
+        // Window draw callback, bounds in global desktop coordinates
+        void drawWindow(int left, int top, int right, int bottom);
+        // A hidden window isn't rendered into, and the main view is drawn even if it is turned off
+        void setWindowVisible(bool visible);
 };
\ No newline at end of file
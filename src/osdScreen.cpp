@@ -0,0 +1,137 @@
+#include "osdScreen.h"
+
+#include <algorithm>
+
+OsdScreen::OsdScreen(unsigned int rows, unsigned int cols)
+{
+    this->rows = rows;
+    this->cols = cols;
+    this->activeRows = rows;
+    this->activeCols = cols;
+    this->cells = std::vector<uint16_t>(rows * cols);
+    this->attributes = std::vector<uint8_t>(rows * cols);
+    this->markDirty(0, rows - 1);
+}
+
+void OsdScreen::markDirty(unsigned int first, unsigned int last)
+{
+    if (this->isDirty()) {
+        this->dirtyFirstRow = std::min(this->dirtyFirstRow, first);
+        this->dirtyLastRow = std::max(this->dirtyLastRow, last);
+    } else {
+        this->dirtyFirstRow = first;
+        this->dirtyLastRow = last;
+    }
+}
+
+void OsdScreen::setActiveGrid(unsigned int rows, unsigned int cols)
+{
+    this->activeRows = std::min(rows, this->rows);
+    this->activeCols = std::min(cols, this->cols);
+}
+
+void OsdScreen::clear()
+{
+    std::fill(this->cells.begin(), this->cells.end(), 0);
+    std::fill(this->attributes.begin(), this->attributes.end(), 0);
+    this->markDirty(0, this->rows - 1);
+}
+
+void OsdScreen::clearRow(unsigned int row)
+{
+    if (row >= this->rows) {
+        return;
+    }
+
+    std::fill_n(this->cells.begin() + row * this->cols, this->cols, 0);
+    std::fill_n(this->attributes.begin() + row * this->cols, this->cols, 0);
+    this->markDirty(row, row);
+}
+
+void OsdScreen::setCharacter(unsigned int row, unsigned int col, uint16_t character)
+{
+    if (row >= this->activeRows || col >= this->activeCols) {
+        return;
+    }
+
+    uint16_t &cell = this->cells[row * this->cols + col];
+    uint8_t &attribute = this->attributes[row * this->cols + col];
+    const uint8_t page = (character >> 8) & OSD_ATTR_PAGE_MASK;
+    if (cell != character || attribute != page) {
+        cell = character;
+        attribute = page;
+        this->markDirty(row, row);
+    }
+}
+
+void OsdScreen::writeRow(unsigned int row, unsigned int col, std::span<const uint8_t> characters, uint8_t attributes)
+{
+    if (row >= this->activeRows || col >= this->activeCols) {
+        return;
+    }
+
+    const uint16_t page = static_cast<uint16_t>(attributes & OSD_ATTR_PAGE_MASK) << 8;
+    const size_t count = std::min<size_t>(characters.size(), this->activeCols - col);
+    uint16_t *cell = &this->cells[row * this->cols + col];
+    uint8_t *attribute = &this->attributes[row * this->cols + col];
+    bool changed = false;
+    for (size_t i = 0; i < count; i++) {
+        const uint16_t character = characters[i] | page;
+        changed |= cell[i] != character || attribute[i] != attributes;
+        cell[i] = character;
+        attribute[i] = attributes;
+    }
+
+    if (changed) {
+        this->markDirty(row, row);
+    }
+}
+
+uint16_t OsdScreen::getCharacter(unsigned int row, unsigned int col) const
+{
+    if (row >= this->rows || col >= this->cols) {
+        return 0;
+    }
+    return this->cells[row * this->cols + col];
+}
+
+uint8_t OsdScreen::getAttributes(unsigned int row, unsigned int col) const
+{
+    if (row >= this->rows || col >= this->cols) {
+        return 0;
+    }
+    return this->attributes[row * this->cols + col];
+}
+
+bool OsdScreen::isBlinking(unsigned int row, unsigned int col) const
+{
+    return this->getAttributes(row, col) & OSD_ATTR_BLINK;
+}
+
+unsigned int OsdScreen::getRows() const
+{
+    return this->rows;
+}
+
+unsigned int OsdScreen::getCols() const
+{
+    return this->cols;
+}
+
+bool OsdScreen::isDirty() const
+{
+    return this->dirtyFirstRow <= this->dirtyLastRow;
+}
+
+bool OsdScreen::getDirtyRows(unsigned int &first, unsigned int &last) const
+{
+    first = this->dirtyFirstRow;
+    last = this->dirtyLastRow;
+    return this->isDirty();
+}
+
+void OsdScreen::clearDirty()
+{
+    this->dirtyFirstRow = 1;
+    this->dirtyLastRow = 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// DisplayPort attribute byte: font page in the low bits, selects the upper 8 bits of the glyph index
+#define OSD_ATTR_PAGE_MASK 0x03
+#define OSD_ATTR_BLINK 0x40
+
+// Character grid as sent by the flight controller. Tracks which rows changed
+// since the renderer last picked up the content.
+class OsdScreen {
+    private:
+        unsigned int rows = 0;
+        unsigned int cols = 0;
+        // Writes are clipped to the grid of the current video system
+        unsigned int activeRows = 0;
+        unsigned int activeCols = 0;
+        std::vector<uint16_t> cells;
+        // Attribute byte of each cell, the page is already part of the glyph index in cells
+        std::vector<uint8_t> attributes;
+        // Inclusive range of changed rows, empty if first > last
+        unsigned int dirtyFirstRow = 0;
+        unsigned int dirtyLastRow = 0;
+
+        void markDirty(unsigned int first, unsigned int last);
+
+    public:
+        OsdScreen(unsigned int rows, unsigned int cols);
+
+        void setActiveGrid(unsigned int rows, unsigned int cols);
+        void clear();
+        void clearRow(unsigned int row);
+        void setCharacter(unsigned int row, unsigned int col, uint16_t character);
+        void writeRow(unsigned int row, unsigned int col, std::span<const uint8_t> characters, uint8_t attributes);
+        uint16_t getCharacter(unsigned int row, unsigned int col) const;
+        uint8_t getAttributes(unsigned int row, unsigned int col) const;
+        bool isBlinking(unsigned int row, unsigned int col) const;
+        unsigned int getRows() const;
+        unsigned int getCols() const;
+        bool isDirty() const;
+        bool getDirtyRows(unsigned int &first, unsigned int &last) const;
+        void clearDirty();
+};
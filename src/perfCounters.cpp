@@ -0,0 +1,68 @@
+#include "perfCounters.h"
+
+#define RATE_INTERVAL_MS 1000
+
+static const char *COUNTER_NAMES[PERF_COUNTER_COUNT] = {
+    "bytes_received",
+    "msp_frames_decoded",
+    "msp_checksum_failures",
+    "msp_resyncs",
+    "dp_commits",
+    "dp_commits_per_second",
+    "draw_calls_per_frame",
+    "render_cpu_us",
+    "tcp_connected",
+    "msp_connected",
+    "dp_heartbeat",
+    "font_cache_loads",
+    "font_decodes",
+    "font_load_us"
+};
+
+std::shared_ptr<PerfCounters> PerfCounters::instance()
+{
+    static std::shared_ptr<PerfCounters> instance = std::make_shared<PerfCounters>();
+    return instance;
+}
+
+const char *PerfCounters::getName(perfCounter_e counter)
+{
+    if (counter < 0 || counter >= PERF_COUNTER_COUNT) {
+        return "";
+    }
+    return COUNTER_NAMES[counter];
+}
+
+void PerfCounters::add(perfCounter_e counter, int64_t value)
+{
+    this->counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+void PerfCounters::set(perfCounter_e counter, int64_t value)
+{
+    this->counters[counter].store(value, std::memory_order_relaxed);
+}
+
+int64_t PerfCounters::get(perfCounter_e counter)
+{
+    return this->counters[counter].load(std::memory_order_relaxed);
+}
+
+void PerfCounters::updateRates(uint32_t timeMs)
+{
+    if (this->lastRateUpdate == 0) {
+        this->lastRateUpdate = timeMs;
+        this->lastCommits = this->get(PERF_DP_COMMITS);
+        return;
+    }
+
+    uint32_t elapsed = timeMs - this->lastRateUpdate;
+    if (elapsed < RATE_INTERVAL_MS) {
+        return;
+    }
+
+    int64_t commits = this->get(PERF_DP_COMMITS);
+    this->set(PERF_DP_COMMITS_PER_SECOND, (commits - this->lastCommits) * 1000 / elapsed);
+    this->lastCommits = commits;
+    this->lastRateUpdate = timeMs;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Host independent counter registry, no XPLM dependencies so it can be 
+// linked into headless builds as well.
+
+typedef enum {
+    PERF_BYTES_RECEIVED,
+    PERF_MSP_FRAMES_DECODED,
+    PERF_MSP_CHECKSUM_FAILURES,
+    PERF_MSP_RESYNCS,
+    PERF_DP_COMMITS,
+    PERF_DP_COMMITS_PER_SECOND,
+    PERF_DRAW_CALLS_PER_FRAME,
+    PERF_RENDER_CPU_US,
+    PERF_TCP_CONNECTED,
+    PERF_MSP_CONNECTED,
+    // DisplayPort heartbeats arrive, the link is alive even while the OSD content is idle
+    PERF_DP_HEARTBEAT,
+    // Font loads, mapped from the glyph cache or decoded from the font files, and their total time
+    PERF_FONT_CACHE_LOADS,
+    PERF_FONT_DECODES,
+    PERF_FONT_LOAD_US,
+    PERF_COUNTER_COUNT
+} perfCounter_e;
+
+class PerfCounters {
+    private:
+        std::array<std::atomic<int64_t>, PERF_COUNTER_COUNT> counters{};
+        int64_t lastCommits = 0;
+        uint32_t lastRateUpdate = 0;
+
+    public:
+        PerfCounters() = default;
+
+        static std::shared_ptr<PerfCounters> instance();
+        PerfCounters(PerfCounters const&) = delete;
+        PerfCounters& operator =(PerfCounters const&) = delete;
+
+        static const char *getName(perfCounter_e counter);
+
+        void add(perfCounter_e counter, int64_t value = 1);
+        void set(perfCounter_e counter, int64_t value);
+        int64_t get(perfCounter_e counter);
+        void updateRates(uint32_t timeMs);
+};
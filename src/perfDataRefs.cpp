@@ -0,0 +1,69 @@
+#include "perfDataRefs.h"
+
+#include <XPLMPlugin.h>
+#include <algorithm>
+#include <climits>
+
+#define DATAREF_EDITOR_SIGNATURE "xplanesdk.examples.DataRefEditor"
+#define DATAREF_TOOL_SIGNATURE   "com.leecbaker.datareftool"
+#define MSG_ADD_DATAREF          0x01000000
+
+PerfDataRefs::~PerfDataRefs()
+{
+    this->unregisterDataRefs();
+}
+
+void PerfDataRefs::registerDataRefs()
+{
+    if (!this->dataRefs.empty()) {
+        return;
+    }
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        std::string name = PERF_DATAREF_PREFIX + PerfCounters::getName(static_cast<perfCounter_e>(i));
+        // Counters are 64 bit, byte counts outgrow an int in long sessions: the double is exact, the int saturates
+        XPLMDataRef ref = XPLMRegisterDataAccessor(name.c_str(), xplmType_Int | xplmType_Float | xplmType_Double, 0,
+                                                   &PerfDataRefs::getCounter, NULL,
+                                                   &PerfDataRefs::getCounterFloat, NULL,
+                                                   &PerfDataRefs::getCounterDouble, NULL,
+                                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                                   reinterpret_cast<void*>(static_cast<intptr_t>(i)), NULL);
+        this->dataRefs.push_back(ref);
+        this->notifyDataRefEditor(name);
+    }
+}
+
+void PerfDataRefs::unregisterDataRefs()
+{
+    for (XPLMDataRef ref : this->dataRefs) {
+        XPLMUnregisterDataAccessor(ref);
+    }
+    this->dataRefs.clear();
+}
+
+int PerfDataRefs::getCounter(void *inRefcon)
+{
+    perfCounter_e counter = static_cast<perfCounter_e>(reinterpret_cast<intptr_t>(inRefcon));
+    return static_cast<int>(std::clamp<int64_t>(PerfCounters::instance()->get(counter), INT_MIN, INT_MAX));
+}
+
+float PerfDataRefs::getCounterFloat(void *inRefcon)
+{
+    return static_cast<float>(getCounterDouble(inRefcon));
+}
+
+double PerfDataRefs::getCounterDouble(void *inRefcon)
+{
+    perfCounter_e counter = static_cast<perfCounter_e>(reinterpret_cast<intptr_t>(inRefcon));
+    return static_cast<double>(PerfCounters::instance()->get(counter));
+}
+
+void PerfDataRefs::notifyDataRefEditor(std::string name)
+{
+    for (const char *signature : {DATAREF_EDITOR_SIGNATURE, DATAREF_TOOL_SIGNATURE}) {
+        XPLMPluginID pluginId = XPLMFindPluginBySignature(signature);
+        if (pluginId != XPLM_NO_PLUGIN_ID) {
+            XPLMSendMessageToPlugin(pluginId, MSG_ADD_DATAREF, (void*)name.c_str());
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "platform.h"
+
+#include <string>
+#include <vector>
+#include <XPLMDataAccess.h>
+
+#include "perfCounters.h"
+
+const std::string PERF_DATAREF_PREFIX = "inav_sitl_osd/perf/";
+
+class PerfDataRefs {
+    private:
+        std::vector<XPLMDataRef> dataRefs;
+
+        static int getCounter(void *inRefcon);
+        static float getCounterFloat(void *inRefcon);
+        static double getCounterDouble(void *inRefcon);
+        void notifyDataRefEditor(std::string name);
+
+    public:
+        PerfDataRefs() = default;
+        ~PerfDataRefs();
+
+        void registerDataRefs();
+        void unregisterDataRefs();
+};
@@ -1,6 +1,7 @@
 #include "platform.h"
 #include "tcp.h"
 #include "helper.h"
+#include "perfCounters.h"
 
 #ifdef LINUX
     #include <arpa/inet.h>
@@ -27,7 +28,7 @@ void TCP::openConnection(std::string address, int port)
 
     this->socketFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (this->socketFd == -1) {
-        Log("Unable to create socket:", strerror(errno));
+        LogError("Unable to create socket: ", strerror(errno));
         return;
     }
 
@@ -39,15 +40,16 @@ void TCP::openConnection(std::string address, int port)
 
     if (connect(this->socketFd, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0)
     {
-        Log("Failed to connect to ", address, ": ", strerror(errno));
+        LogError("Failed to connect to ", address, ": ", strerror(errno));
         this->closeConnection();
         return;
     }
     this->isConnected = true;
+    PerfCounters::instance()->set(PERF_TCP_CONNECTED, 1);
 
     int flags = fcntl(this->socketFd, F_GETFL, 0);
     if (fcntl(this->socketFd, F_SETFL, flags | O_NONBLOCK) < 0) {
-        Log("Failed to set NONBLOCK : ", strerror(errno));
+        LogError("Failed to set NONBLOCK: ", strerror(errno));
         this->closeConnection();
     };
 }
@@ -56,9 +58,10 @@ void TCP::closeConnection()
 {
     if (this->isConnected) {
         if (close(this->socketFd) < 0) {
-            Log("Warning: Unable to close TCP connection properly!");
+            LogWarning("Unable to close TCP connection properly!");
         }
         this->isConnected = false;
+        PerfCounters::instance()->set(PERF_TCP_CONNECTED, 0);
     }
 }
 
@@ -70,7 +73,7 @@ unsigned int TCP::send(std::vector<uint8_t> &buffer)
 
     int sent = write(this->socketFd, (const char*)buffer.data(), buffer.size());
     if (sent < 0) {
-        Log("Unable to send over TCP: ", strerror(errno));
+        LogError("Unable to send over TCP: ", strerror(errno));
         return 0;
     }
 
@@ -0,0 +1,71 @@
+#include "workerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned int threadCount)
+{
+    for (unsigned int i = 0; i < threadCount; i++) {
+        this->workers.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    this->shutdown();
+}
+
+std::shared_ptr<WorkerPool> WorkerPool::instance()
+{
+    static std::shared_ptr<WorkerPool> instance = std::make_shared<WorkerPool>(
+        std::clamp(std::thread::hardware_concurrency() / 2, 1u, static_cast<unsigned int>(WORKER_POOL_MAX_THREADS)));
+    return instance;
+}
+
+void WorkerPool::enqueue(std::function<void()> task)
+{
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (!this->stopping) {
+            this->tasks.push_back(std::move(task));
+            this->condition.notify_one();
+            return;
+        }
+    }
+    // Pool is already shut down, run on the calling thread
+    task();
+}
+
+void WorkerPool::run()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->condition.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+            if (this->tasks.empty()) {
+                return;
+            }
+            task = std::move(this->tasks.front());
+            this->tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void WorkerPool::shutdown()
+{
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (this->stopping) {
+            return;
+        }
+        this->stopping = true;
+    }
+    this->condition.notify_all();
+    for (std::thread &worker : this->workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    this->workers.clear();
+}
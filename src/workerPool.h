@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define WORKER_POOL_MAX_THREADS 4
+
+class WorkerPool {
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool stopping = false;
+
+        void run();
+        void enqueue(std::function<void()> task);
+
+    public:
+        WorkerPool(unsigned int threadCount);
+        ~WorkerPool();
+
+        static std::shared_ptr<WorkerPool> instance();
+        WorkerPool(WorkerPool const&) = delete;
+        WorkerPool& operator =(WorkerPool const&) = delete;
+
+        template<class F>
+        std::shared_future<std::invoke_result_t<F>> submit(F function)
+        {
+            using result_t = std::invoke_result_t<F>;
+            std::shared_ptr<std::packaged_task<result_t()>> task = std::make_shared<std::packaged_task<result_t()>>(std::move(function));
+            std::shared_future<result_t> future = task->get_future().share();
+            this->enqueue([task]() { (*task)(); });
+            return future;
+        }
+
+        // Runs function(i) for i in [0, count) on the pool and the calling thread, returns when all are done.
+        // The caller takes part, so this is safe to use from within a pool task.
+        template<class F>
+        void parallelFor(unsigned int count, F function)
+        {
+            struct state_t {
+                std::atomic<unsigned int> next = 0;
+                std::atomic<unsigned int> done = 0;
+            };
+            std::shared_ptr<state_t> state = std::make_shared<state_t>();
+
+            // Helpers that start after the caller is done find no work left and never touch function
+            auto work = [state, count, &function]() {
+                unsigned int index;
+                while ((index = state->next++) < count) {
+                    function(index);
+                    if (++state->done == count) {
+                        state->done.notify_all();
+                    }
+                }
+            };
+
+            unsigned int helpers = std::min<unsigned int>(this->workers.size(), count > 0 ? count - 1 : 0);
+            for (unsigned int i = 0; i < helpers; i++) {
+                this->enqueue(work);
+            }
+            work();
+
+            unsigned int done;
+            while ((done = state->done) < count) {
+                state->done.wait(done);
+            }
+        }
+
+        void shutdown();
+};